@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+"""Print the WaterBall log messages found in a telemetry stream.
+
+The device only sends the position of a message in WaterBall/log_ids.h and its
+integer arguments. The formats are read from that file, so decode with the
+log_ids.h that the firmware was built from.
+
+Usage:
+    log_decode.py capture.bin
+    log_decode.py --port COM3                           (needs pyserial)
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+from telemetry_decode import RTC_TICKS_PER_SECOND, cobs_decode, crc16, frames
+
+RECORD_LOG = 0x02
+DEFAULT_IDS = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', 'WaterBall', 'log_ids.h')
+
+
+def load_messages(path):
+    messages = []
+    in_table = False
+    with open(path) as ids:
+        for line in ids:
+            if not in_table:
+                in_table = line.startswith('#define LOG_MESSAGES(')
+                continue
+
+            match = re.search(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', line)
+            if match:
+                messages.append((match.group(1), match.group(2)))
+
+            if not line.rstrip().endswith('\\'):
+                break
+    return messages
+
+
+def format_message(messages, message_id, args):
+    if message_id >= len(messages):
+        return 'unknown message %d %s' % (message_id, args)
+
+    name, message = messages[message_id]
+    try:
+        return message % tuple(args)
+    except (TypeError, ValueError):
+        return '%s %s' % (name, args)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', nargs='?', help='a file with the raw serial bytes, stdin if not given')
+    parser.add_argument('--port', help='read straight from a serial port instead')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--ids', default=DEFAULT_IDS, help='the log_ids.h the firmware was built with')
+    args = parser.parse_args()
+
+    messages = load_messages(args.ids)
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.capture:
+        stream = open(args.capture, 'rb')
+    else:
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+
+    for frame in frames(stream):
+        record = cobs_decode(bytearray(frame))
+        if (record is None) or (len(record) < 8) or \
+           (crc16(record[:-2]) != struct.unpack('<H', record[-2:])[0]):
+            continue
+
+        record = record[:-2]
+        if (RECORD_LOG != bytearray(record)[0]) or (0 != (len(record) - 6) % 4):
+            continue
+
+        message_id, ticks = struct.unpack('<BI', record[1:6])
+        values = struct.unpack('<%dI' % ((len(record) - 6) // 4), record[6:])
+        print('%10.4f  %s' % (float(ticks) / RTC_TICKS_PER_SECOND, format_message(messages, message_id, values)))
+        sys.stdout.flush()
+
+
+if __name__ == '__main__':
+    main()
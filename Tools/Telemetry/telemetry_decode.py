@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+"""Decode the WaterBall binary telemetry stream into CSV.
+
+The firmware sends COBS encoded records, each followed by a CRC16 (CCITT, initial
+value 0xFFFF) and sent between zero bytes. See WaterBall/telemetry.h for the layout.
+
+Usage:
+    telemetry_decode.py capture.bin > game.csv
+    telemetry_decode.py --port COM3 > game.csv          (needs pyserial)
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+RECORD_GAME = 0x01
+GAME_FORMAT = '<BIBHHIBHH'
+GAME_FIELDS = ['ticks', 'state', 'my_score', 'their_score', 'ms_remaining',
+               'connected', 'latency_avg_ms', 'latency_lost']
+RTC_TICKS_PER_SECOND = 32768
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in bytearray(data):
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if (crc & 0x8000) else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if 0 == code or (i + code) > (len(frame) + 1):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def frames(stream):
+    frame = bytearray()
+    while True:
+        chunk = stream.read(1)
+        if not chunk:
+            return
+        if 0 == bytearray(chunk)[0]:
+            if frame:
+                yield bytes(frame)
+            frame = bytearray()
+        else:
+            frame += chunk
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument('capture', nargs='?', help='a file with the raw serial bytes, stdin if not given')
+    parser.add_argument('--port', help='read straight from a serial port instead')
+    parser.add_argument('--baud', type=int, default=115200)
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+        stream = serial.Serial(args.port, args.baud)
+    elif args.capture:
+        stream = open(args.capture, 'rb')
+    else:
+        stream = getattr(sys.stdin, 'buffer', sys.stdin)
+
+    writer = csv.writer(sys.stdout, lineterminator='\n')
+    writer.writerow(['seconds'] + GAME_FIELDS)
+    bad = 0
+    for frame in frames(stream):
+        record = cobs_decode(bytearray(frame))
+        if (record is None) or (len(record) < 3) or \
+           (crc16(record[:-2]) != struct.unpack('<H', record[-2:])[0]):
+            # Probably text from the shell mixed in with the records.
+            bad += 1
+            continue
+
+        record = record[:-2]
+        if (RECORD_GAME == bytearray(record)[0]) and (struct.calcsize(GAME_FORMAT) == len(record)):
+            values = struct.unpack(GAME_FORMAT, record)[1:]
+            writer.writerow(['%.4f' % (float(values[0]) / RTC_TICKS_PER_SECOND)] + list(values))
+            sys.stdout.flush()
+
+    if bad:
+        sys.stderr.write('skipped %d bad frames\n' % bad)
+
+
+if __name__ == '__main__':
+    main()
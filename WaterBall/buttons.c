@@ -1,99 +1,248 @@
-/**
- * @file
- * @defgroup WaterBall buttons.c
- * @{
- * @ingroup WaterBall
- * @brief WaterBall buttons module.
- */
-
-#include "app_error.h"
-#include "buttons.h"
-#include "game.h"
-
-static buttons_state_t  m_buttons_state;
-static app_button_cfg_t m_buttons[] =
-{
-    { BUTTON_1, ACTIVE_STATE, PULL_CONFIGURATION, button_event_handler },
-    { BUTTON_2, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler },
-    { BUTTON_3, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler },
-    { BUTTON_4, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler }
-};
-
-
-static void button_event_handler(uint8_t pin_number, uint8_t button_action)
-{
-    if (APP_BUTTON_RELEASE == button_action)
-    {
-        return;
-    }
-
-    switch (pin_number)
-    {
-        case BUTTON_2:
-            LEDS_INVERT(BSP_LED_1_MASK);
-            break;
-        case BUTTON_3:
-            LEDS_INVERT(BSP_LED_2_MASK);
-            break;
-        default:
-            break;
-    }
-}
-
-
-void buttons_init(void)
-{
-    APP_ERROR_CHECK(app_button_init(m_buttons, NUM_BUTTONS, BUTTON_DETECTION_DELAY));
-    APP_ERROR_CHECK(app_button_enable());
-    m_buttons_state = BUTTONS_STATE_INIT;
-}
-
-
-void buttons_tasks(void)
-{
-    switch (m_buttons_state)
-    {
-        case BUTTONS_STATE_INIT:
-        {
-            m_buttons_state = BUTTONS_STATE_READY;
-            break;
-        }
-        case BUTTONS_STATE_READY:
-        {
-            break;
-        }
-        case BUTTONS_STATE_ERROR:
-        {
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-bool buttons_is_pushed(uint32_t pin_no)
-{
-    bool result;
-    uint32_t index = 0;
-
-    for (; index < NUM_BUTTONS; index++)
-    {
-        if (pin_no == m_buttons[index].pin_no)
-        {
-            break;
-        }
-    }
-
-    if (NUM_BUTTONS <= index)
-    {
-        return false;
-    }
-
-    APP_ERROR_CHECK(app_button_is_pushed(index, &result));
-    return result;
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall buttons.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall buttons module.
+ */
+
+#include "app_error.h"
+#include "buttons.h"
+#include "clock.h"
+#include "game.h"
+#include "nrf_ppi.h"
+
+static buttons_state_t          m_buttons_state;
+static nrf_ppi_channel_t        m_capture_channel;      // Captures the time on the press.
+static nrf_ppi_channel_t        m_disarm_channel;       // Disables the group on the press, so only the first edge is captured.
+static nrf_ppi_channel_group_t  m_group;
+static bool                     m_is_timestamping;
+static buttons_capture_t        m_capture;
+static uint64_t                 m_capture_us;
+static uint64_t                 m_poll_us;              // When the capture was last looked at.
+static app_button_cfg_t m_buttons[] =
+{
+    { BUTTON_1, ACTIVE_STATE, PULL_CONFIGURATION, button_event_handler },
+    { BUTTON_2, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler },
+    { BUTTON_3, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler },
+    { BUTTON_4, ACTIVE_STATE, PULL_CONFIGURATION, game_event_handler }
+};
+
+
+static void button_event_handler(uint8_t pin_number, uint8_t button_action)
+{
+    if (APP_BUTTON_RELEASE == button_action)
+    {
+        return;
+    }
+
+    switch (pin_number)
+    {
+        case BUTTON_2:
+            LEDS_INVERT(BSP_LED_1_MASK);
+            break;
+        case BUTTON_3:
+            LEDS_INVERT(BSP_LED_2_MASK);
+            break;
+        default:
+            break;
+    }
+}
+
+
+void buttons_init(void)
+{
+    APP_ERROR_CHECK(app_button_init(m_buttons, NUM_BUTTONS, BUTTON_DETECTION_DELAY));
+    APP_ERROR_CHECK(app_button_enable());
+    buttons_timestamps_init();
+    m_buttons_state = BUTTONS_STATE_INIT;
+}
+
+
+void buttons_tasks(void)
+{
+    switch (m_buttons_state)
+    {
+        case BUTTONS_STATE_INIT:
+        {
+            m_buttons_state = BUTTONS_STATE_READY;
+            break;
+        }
+        case BUTTONS_STATE_READY:
+        {
+            break;
+        }
+        case BUTTONS_STATE_ERROR:
+        {
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+void buttons_timestamps_enable(void)
+{
+    if (m_is_timestamping)
+    {
+        return;
+    }
+
+    clock_hf_request();
+    nrf_gpiote_event_clear(BUTTONS_GPIOTE_EVENT);
+    nrf_gpiote_event_enable(BUTTONS_GPIOTE_CHANNEL);
+    m_is_timestamping = true;
+    buttons_timestamps_rearm();
+}
+
+
+void buttons_timestamps_disable(void)
+{
+    if (!m_is_timestamping)
+    {
+        return;
+    }
+
+    APP_ERROR_CHECK(nrf_drv_ppi_group_disable(m_group));
+    nrf_gpiote_event_disable(BUTTONS_GPIOTE_CHANNEL);
+    clock_hf_release();
+    m_is_timestamping = false;
+}
+
+
+void buttons_timestamps_poll(void)
+{
+    if (!m_is_timestamping)
+    {
+        return;
+    }
+
+    uint64_t now_us = clock_hf_get_us64();
+    switch (m_capture)
+    {
+        case BUTTONS_CAPTURE_ARMED:
+        {
+            // The group is only disabled by an edge.
+            if (NRF_PPI_CHANNEL_ENABLED == nrf_ppi_channel_enable_get(m_capture_channel))
+            {
+                break;
+            }
+
+            if ((now_us - m_poll_us) >= CLOCK_HF_WRAP_US)
+            {
+                // There is no telling which wrap the capture is from.
+                buttons_timestamps_rearm();
+                break;
+            }
+
+            m_capture_us = clock_hf_get_captured_us64(CLOCK_HF_EVENT_CHANNEL);
+            m_capture = BUTTONS_CAPTURE_HELD;
+            break;
+        }
+        case BUTTONS_CAPTURE_HELD:
+        {
+            if ((now_us - m_capture_us) > BUTTONS_PRESS_WINDOW_US)
+            {
+                // No press was reported for it, so it was a bounce.
+                buttons_timestamps_rearm();
+            }
+
+            break;
+        }
+        case BUTTONS_CAPTURE_TAKEN:
+        default:
+        {
+            break;
+        }
+    }
+
+    m_poll_us = now_us;
+}
+
+
+bool buttons_take_press_us(uint64_t * p_us)
+{
+    buttons_timestamps_poll();
+    if (!m_is_timestamping || (BUTTONS_CAPTURE_TAKEN == m_capture))
+    {
+        return false;
+    }
+
+    // Even without a capture nothing more is taken until the release, the edges from now
+    // on are the bounce of this press.
+    bool is_captured = (BUTTONS_CAPTURE_HELD == m_capture);
+    *p_us = m_capture_us;
+    m_capture = BUTTONS_CAPTURE_TAKEN;
+    return is_captured;
+}
+
+
+void buttons_timestamps_rearm(void)
+{
+    if (!m_is_timestamping)
+    {
+        return;
+    }
+
+    APP_ERROR_CHECK(nrf_drv_ppi_group_enable(m_group));
+    m_poll_us = clock_hf_get_us64();
+    m_capture = BUTTONS_CAPTURE_ARMED;
+}
+
+
+bool buttons_is_pushed(uint32_t pin_no)
+{
+    bool result;
+    uint32_t index = 0;
+
+    for (; index < NUM_BUTTONS; index++)
+    {
+        if (pin_no == m_buttons[index].pin_no)
+        {
+            break;
+        }
+    }
+
+    if (NUM_BUTTONS <= index)
+    {
+        return false;
+    }
+
+    APP_ERROR_CHECK(app_button_is_pushed(index, &result));
+    return result;
+}
+
+
+static void buttons_timestamps_init(void)
+{
+    // The ir led pwm may have set up the PPI driver already.
+    uint32_t err_code = nrf_drv_ppi_init();
+    if (MODULE_ALREADY_INITIALIZED != err_code)
+    {
+        APP_ERROR_CHECK(err_code);
+    }
+
+    // app_button keeps watching the pin through the port event, the channel only adds the
+    // event that the PPI channels hang off. It stays disabled until it is needed.
+    APP_ERROR_CHECK_BOOL(!nrf_gpiote_te_is_enabled(BUTTONS_GPIOTE_CHANNEL));
+    nrf_gpiote_event_configure(BUTTONS_GPIOTE_CHANNEL, BUTTONS_TIMESTAMP_PIN, NRF_GPIOTE_POLARITY_HITOLO);
+    uint32_t event_address = nrf_gpiote_event_addr_get(BUTTONS_GPIOTE_EVENT);
+
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_alloc(&m_capture_channel));
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_alloc(&m_disarm_channel));
+    APP_ERROR_CHECK(nrf_drv_ppi_group_alloc(&m_group));
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(m_capture_channel,
+                                               event_address,
+                                               clock_hf_get_capture_task_address(CLOCK_HF_EVENT_CHANNEL)));
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_assign(m_disarm_channel,
+                                               event_address,
+                                               nrf_drv_ppi_task_addr_group_disable_get(m_group)));
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_include_in_group(m_capture_channel, m_group));
+    APP_ERROR_CHECK(nrf_drv_ppi_channel_include_in_group(m_disarm_channel, m_group));
+    m_is_timestamping = false;
+}
+
+/** @} */
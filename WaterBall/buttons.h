@@ -1,70 +1,149 @@
-/**
- * @file
- * @defgroup WaterBall buttons.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall buttons module.
- *
- * Setup buttons.
- */
-
-#ifndef BUTTONS_H__
-#define BUTTONS_H__
-
-#include "app_button.h"
-#include "app_timer.h"
-#include "bsp.h"
-#include "nrf_soc.h"
-
-#define ACTIVE_STATE                APP_BUTTON_ACTIVE_LOW
-#define PULL_CONFIGURATION          NRF_GPIO_PIN_PULLUP
-#define BUTTON_DETECTION_DELAY      APP_TIMER_MIN_TIMEOUT_TICKS //APP_TIMER_TICKS(1, APP_TIMER_PRESCALER)
-
-/**
- * @brief The number of mapping pins in mapping structure.
- */
-#define NUM_BUTTONS                                         \
-        sizeof(m_buttons) / sizeof(app_button_cfg_t)
-
-/**
- * @brief gpio module states.
- */
-typedef enum
-{
-    BUTTONS_STATE_INIT,             /**< The buttons module is initializing. */
-    BUTTONS_STATE_READY,            /**< The buttons module is ready. */
-    BUTTONS_STATE_ERROR             /**< The buttons module has received an error. */
-} buttons_state_t;
-
-/**
- * @brief   Event handler that runs when a button is pressed.
- *
- * @param[in]   pin_number      The number of the pin that was pressed.
- * @param[in]   button_action   The action (press or release) of the button.
- */
-static void button_event_handler(uint8_t pin_number, uint8_t button_action);
-
-/**
- * @brief   Function to initialize the sleep module.
- */
-void buttons_init(void);
-
-/**
- * @brief   Function to accomplish the sleep module tasks.
- *
- * @details This should be called repeatedly from the main loop.
- */
-void buttons_tasks(void);
-
-/**
- * @brief   Function fo find the state of the button.
- *
- * @param[in]   pin_no      The pin number you want to know is pushed.
- *
- * @retval      True if pushed.
- */
-bool buttons_is_pushed(uint32_t pin_no);
-
-#endif //BUTTONS_H__
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall buttons.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall buttons module.
+ *
+ * Setup buttons.
+ *
+ * Presses of the score button are also timestamped in hardware while the game is being
+ * played. Its GPIOTE event captures the high resolution time of the clock module through
+ * a PPI channel, so the timestamp is exact to the microsecond however long it takes the
+ * CPU to get to it. A second PPI channel on the same event disables the channel group the
+ * two channels are in, so the first edge is kept and the contact bounce doesn't overwrite
+ * it.
+ *
+ * A capture is only taken for a press that app_button reports after its debounce, and the
+ * group is only enabled again once app_button reports the release, so the bounce of the
+ * same press can't be counted as another one. Edges that no press is reported for, like
+ * the bounce of the release, are thrown away once they are BUTTONS_PRESS_WINDOW_US old.
+ * The capture only holds the low 16 bits of the time, so it is polled at least once a
+ * timer wrap and a capture that may have sat longer than that is thrown away too.
+ *
+ * The gpiote driver can't be asked for the channel: app_button already holds the pin in
+ * the driver, through the port event, and the driver only gives a pin one channel. So the
+ * channel is set up directly. The driver only hands out channels for high accuracy inputs
+ * and task outputs, no module asks it for one, and init checks the channel is still free.
+ */
+
+#ifndef BUTTONS_H__
+#define BUTTONS_H__
+
+#include "app_button.h"
+#include "app_timer.h"
+#include "bsp.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_gpiote.h"
+#include "nrf_soc.h"
+
+#define ACTIVE_STATE                APP_BUTTON_ACTIVE_LOW
+#define PULL_CONFIGURATION          NRF_GPIO_PIN_PULLUP
+#define BUTTON_DETECTION_DELAY      APP_TIMER_MIN_TIMEOUT_TICKS //APP_TIMER_TICKS(1, APP_TIMER_PRESCALER)
+
+#define BUTTONS_TIMESTAMP_PIN       BUTTON_3                    /**< The score button. */
+#define BUTTONS_GPIOTE_CHANNEL      (GPIOTE_CH_NUM - 1)         /**< The gpiote driver hands out channels from the bottom, so take the top one. */
+#define BUTTONS_GPIOTE_EVENT        ((nrf_gpiote_events_t)(NRF_GPIOTE_EVENTS_IN_0 + (sizeof(uint32_t) * BUTTONS_GPIOTE_CHANNEL)))   /**< The IN events are one register apart, in channel order. */
+#define BUTTONS_PRESS_WINDOW_US     (20000)                     /**< app_button reports a press well within this of its first edge, it must be under a timer wrap. */
+
+/**
+ * @brief The number of mapping pins in mapping structure.
+ */
+#define NUM_BUTTONS                                         \
+        sizeof(m_buttons) / sizeof(app_button_cfg_t)
+
+/**
+ * @brief gpio module states.
+ */
+typedef enum
+{
+    BUTTONS_STATE_INIT,             /**< The buttons module is initializing. */
+    BUTTONS_STATE_READY,            /**< The buttons module is ready. */
+    BUTTONS_STATE_ERROR             /**< The buttons module has received an error. */
+} buttons_state_t;
+
+/**
+ * @brief   States of the score button capture.
+ */
+typedef enum
+{
+    BUTTONS_CAPTURE_ARMED,          /**< Waiting for an edge. */
+    BUTTONS_CAPTURE_HELD,           /**< An edge was captured, waiting for app_button to report the press. */
+    BUTTONS_CAPTURE_TAKEN           /**< The press was reported, waiting for the release. */
+} buttons_capture_t;
+
+/**
+ * @brief   Event handler that runs when a button is pressed.
+ *
+ * @param[in]   pin_number      The number of the pin that was pressed.
+ * @param[in]   button_action   The action (press or release) of the button.
+ */
+static void button_event_handler(uint8_t pin_number, uint8_t button_action);
+
+/**
+ * @brief   Set up the GPIOTE event and the PPI channels that timestamp the score button.
+ */
+static void buttons_timestamps_init(void);
+
+/**
+ * @brief   Function to initialize the sleep module.
+ */
+void buttons_init(void);
+
+/**
+ * @brief   Function to accomplish the sleep module tasks.
+ *
+ * @details This should be called repeatedly from the main loop.
+ */
+void buttons_tasks(void);
+
+/**
+ * @brief   Start timestamping the presses of the score button.
+ *
+ * @details This keeps the high resolution time running, so only do it while it is needed.
+ *          Presses from before the call are forgotten.
+ */
+void buttons_timestamps_enable(void);
+
+/**
+ * @brief   Stop timestamping the presses of the score button.
+ */
+void buttons_timestamps_disable(void);
+
+/**
+ * @brief   Keep the capture of the score button up to date.
+ *
+ * @details This must be called from the main loop at least every CLOCK_HF_WRAP_US while
+ *          the presses are timestamped, or the captures are thrown away.
+ */
+void buttons_timestamps_poll(void);
+
+/**
+ * @brief   Get the timestamp of a press of the score button that app_button has reported.
+ *
+ * @details Call it once for each reported press. No more edges are captured until the
+ *          release is passed to buttons_timestamps_rearm.
+ *
+ * @param[out]  p_us        When the button was pressed, on the high resolution time.
+ *
+ * @retval      True if the press was captured.
+ */
+bool buttons_take_press_us(uint64_t * p_us);
+
+/**
+ * @brief   Start capturing again, once app_button has reported the release of the score button.
+ */
+void buttons_timestamps_rearm(void);
+
+/**
+ * @brief   Function fo find the state of the button.
+ *
+ * @param[in]   pin_no      The pin number you want to know is pushed.
+ *
+ * @retval      True if pushed.
+ */
+bool buttons_is_pushed(uint32_t pin_no);
+
+#endif //BUTTONS_H__
+
+/** @} */
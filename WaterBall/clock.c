@@ -1,79 +1,244 @@
-/**
- * @file
- * @defgroup WaterBall clock.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall clock module.
- */
-
-#include "ble_stack.h"
-#include "clock.h"
-#include "nrf_drv_clock.h"
-
-APP_TIMER_DEF(m_loop_timer_id);
-
-static void clock_handler(void * p_context)
-{
-}
-
-
-void clock_init(void)
-{
-    // Initialize the low frequency clock.
-    APP_ERROR_CHECK(nrf_drv_clock_init());
-    nrf_drv_clock_lfclk_request(NULL);
-
-    // Create timers.
-    APP_ERROR_CHECK(app_timer_create(&m_loop_timer_id, APP_TIMER_MODE_REPEATED, clock_handler));
-    APP_ERROR_CHECK(app_timer_start(m_loop_timer_id, CLOCK_S_IN_TICKS(2), NULL));
-}
-
-
-void clock_tasks(void)
-{
-}
-
-
-uint32_t clock_get_ticks(void)
-{
-    uint32_t ticks;
-    APP_ERROR_CHECK(app_timer_cnt_get(&ticks));
-    return ticks;
-}
-
-
-bool clock_ticks_have_passed(uint32_t start, uint32_t ticks)
-{
-    return clock_ticks_since(start) >= ticks;
-}
-
-
-bool clock_ms_have_passed(uint32_t start, uint32_t ms)
-{
-    return clock_ms_since(start) >= ms;
-}
-
-
-uint32_t clock_ms_until(uint32_t start, uint32_t ticks)
-{
-    uint32_t passed = clock_ticks_since(start);
-    return passed >= ticks ? 0 : CLOCK_TICKS_IN_MS(ticks - passed);
-}
-
-
-uint32_t clock_ms_since(uint32_t start)
-{
-    return CLOCK_TICKS_IN_MS(clock_ticks_since(start));
-}
-
-
-static inline uint32_t clock_ticks_since(uint32_t start)
-{
-    uint32_t stop;
-    uint32_t ticks_diff;
-    APP_ERROR_CHECK(app_timer_cnt_get(&stop));
-    APP_ERROR_CHECK(app_timer_cnt_diff_compute(stop, start, &ticks_diff));
-    return ticks_diff;
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall clock.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall clock module.
+ */
+
+#include "app_util_platform.h"
+#include "ble_stack.h"
+#include "clock.h"
+#include "nrf_drv_clock.h"
+
+#if (APP_TIMER_CLOCK_FREQ != 32768)
+#error "The fixed point tick conversions assume a 32768 Hz RTC."
+#endif
+
+static clock_time_source_t      m_time_source = clock_rtc_get_ticks;
+static volatile uint32_t        m_sim_ticks;
+static volatile uint32_t        m_wraps;                // The upper bits of the 64 bit ticks.
+static volatile uint32_t        m_last_ticks;           // The ticks when the wraps were last brought up to date.
+static const nrf_drv_timer_t    m_hf_timer = NRF_DRV_TIMER_INSTANCE(CLOCK_HF_TIMER_INSTANCE);
+static uint32_t                 m_hf_requests;
+static volatile uint32_t        m_hf_wraps;
+
+
+void clock_init(void)
+{
+    // Initialize the low frequency clock.
+    APP_ERROR_CHECK(nrf_drv_clock_init());
+    nrf_drv_clock_lfclk_request(NULL);
+
+    m_wraps = 0;
+    m_last_ticks = clock_get_ticks();
+
+    const nrf_drv_timer_config_t config =
+    {
+        .frequency          = CLOCK_HF_TIMER_FREQUENCY,
+        .mode               = NRF_TIMER_MODE_TIMER,
+        .bit_width          = NRF_TIMER_BIT_WIDTH_16,
+        .interrupt_priority = APP_IRQ_PRIORITY_LOW,
+        .p_context          = NULL
+    };
+
+    APP_ERROR_CHECK(nrf_drv_timer_init(&m_hf_timer, &config, clock_hf_handler));
+    nrf_drv_timer_compare(&m_hf_timer, CLOCK_HF_WRAP_CHANNEL, 0, true);
+    m_hf_requests = 0;
+    m_hf_wraps = 0;
+}
+
+
+void clock_tasks(void)
+{
+    // The clock is registered with a period, so that the wraps are counted even when nothing else is going on.
+    clock_extend();
+}
+
+
+void clock_set_time_source(clock_time_source_t time_source)
+{
+    m_time_source = (NULL == time_source) ? clock_rtc_get_ticks : time_source;
+
+    // The 64 bit ticks start again from the new source.
+    m_wraps = 0;
+    m_last_ticks = clock_get_ticks();
+}
+
+
+uint32_t clock_sim_get_ticks(void)
+{
+    return m_sim_ticks;
+}
+
+
+void clock_sim_set_ticks(uint32_t ticks)
+{
+    m_sim_ticks = ticks & CLOCK_TICKS_MASK;
+}
+
+
+void clock_sim_advance_ticks(uint32_t ticks)
+{
+    m_sim_ticks = (m_sim_ticks + ticks) & CLOCK_TICKS_MASK;
+}
+
+
+uint32_t clock_get_ticks(void)
+{
+    return m_time_source();
+}
+
+
+uint64_t clock_get_ticks64(void)
+{
+    uint32_t wraps;
+    uint32_t last_ticks;
+    uint32_t ticks;
+
+    do
+    {
+        wraps = m_wraps;
+        last_ticks = m_last_ticks;
+        ticks = clock_get_ticks();
+    } while (wraps != m_wraps);
+
+    // The wraps are at most one behind, since they are brought up to date more often than that.
+    if (ticks < last_ticks)
+    {
+        wraps++;
+    }
+
+    return ((uint64_t)wraps << CLOCK_TICKS_BITS) | ticks;
+}
+
+
+uint64_t clock_get_us64(void)
+{
+    return CLOCK_TICKS_IN_US(clock_get_ticks64());
+}
+
+
+void clock_hf_request(void)
+{
+    if (0 == m_hf_requests++)
+    {
+        nrf_drv_timer_clear(&m_hf_timer);
+        nrf_drv_timer_enable(&m_hf_timer);
+    }
+}
+
+
+void clock_hf_release(void)
+{
+    if (0 == --m_hf_requests)
+    {
+        nrf_drv_timer_disable(&m_hf_timer);
+    }
+}
+
+
+uint64_t clock_hf_get_us64(void)
+{
+    uint32_t wraps;
+    uint32_t us;
+    bool is_wrap_pending;
+
+    // If the wrap interrupt ran while we were reading the timer, the wraps will have moved.
+    // If it hasn't run yet, because we are in an interrupt or it is held off, the event is
+    // still set, and a small time is from after the wrap that hasn't been counted.
+    do
+    {
+        wraps = m_hf_wraps;
+        us = nrf_drv_timer_capture(&m_hf_timer, CLOCK_HF_NOW_CHANNEL);
+        is_wrap_pending = nrf_timer_event_check(m_hf_timer.p_reg, nrf_timer_compare_event_get(CLOCK_HF_WRAP_CHANNEL));
+    } while (wraps != m_hf_wraps);
+
+    if (is_wrap_pending && (us < (CLOCK_HF_WRAP_US / 2)))
+    {
+        wraps++;
+    }
+
+    return ((uint64_t)wraps << CLOCK_HF_TIMER_BITS) | us;
+}
+
+
+uint64_t clock_hf_get_captured_us64(nrf_timer_cc_channel_t channel)
+{
+    uint64_t now = clock_hf_get_us64();
+    uint32_t captured = nrf_drv_timer_capture_get(&m_hf_timer, channel);
+    return now - (((uint32_t)now - captured) & CLOCK_HF_TIMER_MASK);
+}
+
+
+uint32_t clock_hf_get_capture_task_address(nrf_timer_cc_channel_t channel)
+{
+    return nrf_drv_timer_capture_task_address_get(&m_hf_timer, channel);
+}
+
+
+bool clock_ticks_have_passed(uint32_t start, uint32_t ticks)
+{
+    return clock_ticks_since(start) >= ticks;
+}
+
+
+bool clock_ms_have_passed(uint32_t start, uint32_t ms)
+{
+    return clock_ms_since(start) >= ms;
+}
+
+
+uint32_t clock_ms_until(uint32_t start, uint32_t ticks)
+{
+    uint32_t passed = clock_ticks_since(start);
+    return passed >= ticks ? 0 : CLOCK_TICKS_IN_MS(ticks - passed);
+}
+
+
+uint32_t clock_ms_since(uint32_t start)
+{
+    return CLOCK_TICKS_IN_MS(clock_ticks_since(start));
+}
+
+
+uint32_t clock_ticks_since(uint32_t start)
+{
+    // Same as app_timer_cnt_diff_compute, but works with any time source.
+    return (clock_get_ticks() - start) & CLOCK_TICKS_MASK;
+}
+
+
+static uint32_t clock_rtc_get_ticks(void)
+{
+    uint32_t ticks;
+    APP_ERROR_CHECK(app_timer_cnt_get(&ticks));
+    return ticks;
+}
+
+
+static void clock_extend(void)
+{
+    // Readers check the wraps to see that they have a matching pair, so the pair must not be
+    // seen half written by an interrupt that preempts us.
+    CRITICAL_REGION_ENTER();
+    uint32_t ticks = clock_get_ticks();
+    if (ticks < m_last_ticks)
+    {
+        m_wraps++;
+    }
+
+    m_last_ticks = ticks;
+    CRITICAL_REGION_EXIT();
+}
+
+
+static void clock_hf_handler(nrf_timer_event_t event_type, void * p_context)
+{
+    if (nrf_timer_compare_event_get(CLOCK_HF_WRAP_CHANNEL) == event_type)
+    {
+        m_hf_wraps++;
+    }
+}
+
+/** @} */
@@ -1,92 +1,248 @@
-/**
- * @file
- * @defgroup WaterBall clock.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall clock module.
- */
-
-#ifndef CLOCK_H__
-#define CLOCK_H__
-
-#include <stdbool.h>
-#include <stdint.h>
-
-#include "app_timer.h"
-#include "ble_stack.h"
-
-#define CLOCK_MS_IN_TICKS(MS)               (APP_TIMER_TICKS(MS, APP_TIMER_PRESCALER))
-#define CLOCK_S_IN_TICKS(S)                 (CLOCK_MS_IN_TICKS(S * 1000))
-#define CLOCK_TICKS_IN_MS(TICKS)            ((uint32_t)ROUNDED_DIV((uint64_t)(TICKS) * ((APP_TIMER_PRESCALER) + 1) * 1000, APP_TIMER_CLOCK_FREQ))
-
-/**
- * @brief   Function to initialize the clock module.
- */
-void clock_init(void);
-
-/**
- * @brief   Function to accomplish the clock module tasks.
- *
- * @details This should be called repeatedly from the main loop.
- */
-void clock_tasks(void);
-
-/**
- * @brief   Get the current value of the ticks clock.
- *
- * @retval  The ticks value right now.
- */
-uint32_t clock_get_ticks(void);
-
-/**
- * @brief   Test to see if 'ticks' ticks have passed since the 'start'.
- *
- * @param[in]   start           The time (also in ticks) to start measuring from - obtained from "clock_get_ticks".
- * @param[in]   ticks           The number of ticks that we are waiting to have passed.
- *
- * @retval      True if "ticks" have passed since the start.
- */
-bool clock_ticks_have_passed(uint32_t start, uint32_t ticks);
-
-/**
- * @brief   Test to see if 'ms' milliseconds have passed since the 'start'.
- *
- * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
- * @param[in]   ms              The number of ms that we are waiting to have passed.
- *
- * @retval      True if "ticks" have passed since the start.
- */
-bool clock_ms_have_passed(uint32_t start, uint32_t ms);
-
-/**
- * @brief   Get the number of milliseconds that still remain until ticks have passed counting from start.
- *
- * @param[in]   start           The time to start measuring from - obtained from "clock_get_ticks".
- * @param[in]   ticks           The number of ticks that we want to pass from the starting point.
- *
- * @retval      The number of milliseconds we still have to wait until ticks have passed since the start
- *              or 0 if ticks have already passed since start.
- */
-uint32_t clock_ms_until(uint32_t start, uint32_t ticks);
-
-/**
- * @brief   Get the number of milliseconds that have passed since a starting point.
- *
- * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
- *
- * @retval      The number of milliseconds since the start.
- */
-uint32_t clock_ms_since(uint32_t start);
-
-/**
- * @brief   Get the number of click ticks that have passed since a starting point.
- *
- * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
- *
- * @retval      The number of ticks since the start.
- */
-static inline uint32_t clock_ticks_since(uint32_t start);
-
-#endif //CLOCK_H__
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall clock.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall clock module.
+ *
+ * The 32 bit ticks wrap with the 24 bit RTC, after 512 s at prescaler 0, so they are only
+ * good for measuring short intervals. For uptime and timestamps there is a 64 bit tick
+ * count that never wraps. The scheduler runs clock_tasks every CLOCK_EXTEND_PERIOD_MS,
+ * far more often than the RTC wraps, and clock_extend counts the wraps from there.
+ * Reading the 64 bit ticks doesn't need a critical region: the wrap count is read again
+ * at the end, and the read is retried if clock_extend moved it in between.
+ *
+ * For timing that needs better than the 30 us of the RTC there is a high resolution
+ * time in microseconds from a hardware TIMER. It keeps the 16 MHz clock running, so it
+ * only runs while some module has requested it, and times from different requests can't
+ * be compared. The TIMER is only 16 bits on the nRF51, so a compare on every wrap counts
+ * the wraps to make it 64 bits. Its capture channels are shared out like this:
+ *
+ * - CLOCK_HF_NOW_CHANNEL is captured to read the time now, only from the main loop.
+ * - CLOCK_HF_WRAP_CHANNEL is the compare that counts the wraps.
+ * - CLOCK_HF_EVENT_CHANNEL is captured by a PPI channel to timestamp a hardware event
+ *   with no CPU latency, the buttons module uses it for the score button.
+ */
+
+#ifndef CLOCK_H__
+#define CLOCK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_timer.h"
+#include "ble_stack.h"
+#include "nrf_drv_timer.h"
+
+#define CLOCK_MS_IN_TICKS(MS)               (APP_TIMER_TICKS(MS, APP_TIMER_PRESCALER))
+#define CLOCK_S_IN_TICKS(S)                 (CLOCK_MS_IN_TICKS(S * 1000))
+#define CLOCK_TICKS_IN_MS(TICKS)            ((uint32_t)(((uint64_t)(TICKS) * CLOCK_MS_PER_TICK_Q12 + (1 << 11)) >> 12))
+#define CLOCK_TICKS_IN_US(TICKS)            (((uint64_t)(TICKS) * CLOCK_US_PER_TICK_Q9) >> 9)
+
+#define CLOCK_MS_PER_TICK_Q12               (125 * ((APP_TIMER_PRESCALER) + 1))     /**< 1000 / 32768 = 125 / 2^12, so this fixed point multiplier is exact. */
+#define CLOCK_US_PER_TICK_Q9                (15625 * ((APP_TIMER_PRESCALER) + 1))   /**< 1000000 / 32768 = 15625 / 2^9, also exact. */
+#define CLOCK_TICKS_BITS                    (24)
+
+#define CLOCK_EXTEND_PERIOD_MS              (60000)     /**< How often the wraps are counted, this must be well under the 512 s it takes the ticks to wrap. */
+#define CLOCK_TICKS_MASK                    (0x00FFFFFF)    /**< The RTC counter is only 24 bits, so every time source wraps at the same place. */
+
+#define CLOCK_HF_TIMER_INSTANCE             (2)                         /**< TIMER0 belongs to the SoftDevice and TIMER1 to the ir led pwm. */
+#define CLOCK_HF_TIMER_FREQUENCY            NRF_TIMER_FREQ_1MHz         /**< One tick is a microsecond. */
+#define CLOCK_HF_TIMER_BITS                 (16)
+#define CLOCK_HF_TIMER_MASK                 (0xFFFF)                    /**< The timer wraps every 65.5 ms. */
+#define CLOCK_HF_WRAP_US                    (CLOCK_HF_TIMER_MASK + 1)
+#define CLOCK_HF_NOW_CHANNEL                NRF_TIMER_CC_CHANNEL0
+#define CLOCK_HF_WRAP_CHANNEL               NRF_TIMER_CC_CHANNEL1
+#define CLOCK_HF_EVENT_CHANNEL              NRF_TIMER_CC_CHANNEL2
+
+/**
+ * @brief   A source of ticks, it must count up at APP_TIMER_CLOCK_FREQ / (APP_TIMER_PRESCALER + 1)
+ *          and wrap at CLOCK_TICKS_MASK like the RTC does.
+ */
+typedef uint32_t (* clock_time_source_t)(void);
+
+/**
+ * @brief   Function to initialize the clock module.
+ */
+void clock_init(void);
+
+/**
+ * @brief   Function to accomplish the clock module tasks.
+ *
+ * @details This must be run at least every CLOCK_EXTEND_PERIOD_MS.
+ */
+void clock_tasks(void);
+
+/**
+ * @brief   Change where the ticks come from.
+ *
+ * @details Ticks that were obtained from the previous time source are meaningless to the
+ *          new one, so this should only be done before the modules start measuring time.
+ *          The app_timer timeouts still run on the RTC.
+ *
+ * @param[in]   time_source     The new source of ticks, or NULL to go back to the RTC.
+ */
+void clock_set_time_source(clock_time_source_t time_source);
+
+/**
+ * @brief   A simulated RTC that only moves when it is told to, it can be used as a time source.
+ *
+ * @retval  The current value of the simulated RTC.
+ */
+uint32_t clock_sim_get_ticks(void);
+
+/**
+ * @brief   Set the simulated RTC to a value, for example just before the 24 bit wrap.
+ *
+ * @param[in]   ticks           The new value of the simulated RTC.
+ */
+void clock_sim_set_ticks(uint32_t ticks);
+
+/**
+ * @brief   Move the simulated RTC forward, wrapping the same way the RTC does.
+ *
+ * @param[in]   ticks           The number of ticks to move forward.
+ */
+void clock_sim_advance_ticks(uint32_t ticks);
+
+/**
+ * @brief   Get the current value of the ticks clock.
+ *
+ * @retval  The ticks value right now.
+ */
+uint32_t clock_get_ticks(void);
+
+/**
+ * @brief   Get the number of ticks since the clock module was initialized, it never wraps.
+ *
+ * @details This is safe to call from any context.
+ *
+ * @retval  The 64 bit ticks value right now.
+ */
+uint64_t clock_get_ticks64(void);
+
+/**
+ * @brief   Get the number of microseconds since the clock module was initialized.
+ *
+ * @retval  The uptime in microseconds.
+ */
+uint64_t clock_get_us64(void);
+
+/**
+ * @brief   Start the high resolution time, if it isn't running already.
+ *
+ * @details Every request must be matched by a release.
+ */
+void clock_hf_request(void);
+
+/**
+ * @brief   Stop the high resolution time once every request has been released.
+ */
+void clock_hf_release(void);
+
+/**
+ * @brief   Get the high resolution time.
+ *
+ * @details This must only be called while the time is requested. A wrap that its interrupt
+ *          hasn't counted yet is allowed for, but the interrupt mustn't be held off for a
+ *          whole wrap.
+ *
+ * @retval  The microseconds since the high resolution time was started.
+ */
+uint64_t clock_hf_get_us64(void);
+
+/**
+ * @brief   Get the high resolution time that was captured in a channel by a hardware event.
+ *
+ * @details The capture is placed relative to the time now, so it must be less than one wrap
+ *          of the timer old.
+ *
+ * @param[in]   channel         The channel the event was captured in.
+ *
+ * @retval  The microseconds since the high resolution time was started, when the event happened.
+ */
+uint64_t clock_hf_get_captured_us64(nrf_timer_cc_channel_t channel);
+
+/**
+ * @brief   Get the address of the task that captures the high resolution time, for a PPI channel.
+ *
+ * @param[in]   channel         The channel to capture in.
+ *
+ * @retval  The address of the capture task.
+ */
+uint32_t clock_hf_get_capture_task_address(nrf_timer_cc_channel_t channel);
+
+/**
+ * @brief   Test to see if 'ticks' ticks have passed since the 'start'.
+ *
+ * @param[in]   start           The time (also in ticks) to start measuring from - obtained from "clock_get_ticks".
+ * @param[in]   ticks           The number of ticks that we are waiting to have passed.
+ *
+ * @retval      True if "ticks" have passed since the start.
+ */
+bool clock_ticks_have_passed(uint32_t start, uint32_t ticks);
+
+/**
+ * @brief   Test to see if 'ms' milliseconds have passed since the 'start'.
+ *
+ * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
+ * @param[in]   ms              The number of ms that we are waiting to have passed.
+ *
+ * @retval      True if "ticks" have passed since the start.
+ */
+bool clock_ms_have_passed(uint32_t start, uint32_t ms);
+
+/**
+ * @brief   Get the number of milliseconds that still remain until ticks have passed counting from start.
+ *
+ * @param[in]   start           The time to start measuring from - obtained from "clock_get_ticks".
+ * @param[in]   ticks           The number of ticks that we want to pass from the starting point.
+ *
+ * @retval      The number of milliseconds we still have to wait until ticks have passed since the start
+ *              or 0 if ticks have already passed since start.
+ */
+uint32_t clock_ms_until(uint32_t start, uint32_t ticks);
+
+/**
+ * @brief   Get the number of milliseconds that have passed since a starting point.
+ *
+ * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
+ *
+ * @retval      The number of milliseconds since the start.
+ */
+uint32_t clock_ms_since(uint32_t start);
+
+/**
+ * @brief   Get the number of click ticks that have passed since a starting point.
+ *
+ * @param[in]   start           The time (in ticks) to start measuring from - obtained from "clock_get_ticks".
+ *
+ * @retval      The number of ticks since the start.
+ */
+uint32_t clock_ticks_since(uint32_t start);
+
+/**
+ * @brief   The default time source - the RTC used by the app_timer module.
+ *
+ * @retval  The current value of the RTC.
+ */
+static uint32_t clock_rtc_get_ticks(void);
+
+/**
+ * @brief   Count a wrap of the ticks if there was one since the last call.
+ *
+ * @details This must be called more often than the ticks wrap, and only from one context.
+ */
+static void clock_extend(void);
+
+/**
+ * @brief   Count the wraps of the high resolution timer.
+ *
+ * @param[in]   event_type      The compare event of the wrap channel.
+ * @param[in]   p_context       Not used.
+ */
+static void clock_hf_handler(nrf_timer_event_t event_type, void * p_context);
+
+#endif //CLOCK_H__
+
+/** @} */
@@ -0,0 +1,235 @@
+/**
+ * @file
+ * @defgroup WaterBall format.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall number formatting module.
+ */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "format.h"
+
+
+uint32_t format_decimal(char * p_buffer, uint32_t value, uint32_t min_width)
+{
+    char digits[FORMAT_DECIMAL_MAX_DIGITS];
+    uint32_t count = 0;
+
+    // Work out the digits from the lowest order up, then copy them out in the right order.
+    do
+    {
+        uint32_t quotient = format_div10(value);
+        digits[count++] = '0' + (value - (quotient * 10));
+        value = quotient;
+    } while (0 != value);
+
+    uint32_t size = 0;
+    for (; (size + count) < min_width; size++)
+    {
+        p_buffer[size] = '0';
+    }
+
+    while (0 < count)
+    {
+        p_buffer[size++] = digits[--count];
+    }
+
+    p_buffer[size] = '\0';
+    return size;
+}
+
+
+uint32_t format_score(char * p_buffer, uint32_t score, uint32_t width)
+{
+    // Fill in from the lowest order digit, if there is anything left over it didn't fit.
+    for (uint32_t i = width; 0 < i; i--)
+    {
+        uint32_t quotient = format_div10(score);
+        p_buffer[i - 1] = '0' + (score - (quotient * 10));
+        score = quotient;
+    }
+
+    if (0 != score)
+    {
+        for (uint32_t i = 0; i < width; i++)
+        {
+            p_buffer[i] = FORMAT_OVERFLOW_CHAR;
+        }
+    }
+
+    p_buffer[width] = '\0';
+    return width;
+}
+
+
+uint32_t format_time(char * p_buffer, uint32_t ms, format_time_t format)
+{
+    uint32_t centiseconds = format_div10(ms);
+    uint32_t seconds = format_div10(format_div10(centiseconds));
+    uint32_t left;
+    uint32_t right;
+    char separator;
+
+    if (FORMAT_TIME_SS_CC == format)
+    {
+        left = seconds;
+        right = centiseconds - (seconds * 100);
+        separator = '.';
+    }
+    else
+    {
+        // 0x88888889 / 2^37 is close enough to 1/60 that this is exact for every 32 bit value.
+        left = (uint32_t)(((uint64_t)seconds * 0x88888889UL) >> 37);
+        right = seconds - (left * 60);
+        separator = ':';
+    }
+
+    format_score(&p_buffer[0], left, 2);
+    format_score(&p_buffer[3], (FORMAT_OVERFLOW_CHAR == p_buffer[0]) ? UINT32_MAX : right, 2);
+    p_buffer[2] = separator;
+    return FORMAT_TIME_SIZE;
+}
+
+
+uint32_t format_vstring(char * p_buffer, uint32_t size, char const * p_format, va_list args)
+{
+    uint32_t count = 0;
+
+    while (('\0' != *p_format) && ((count + 1) < size))
+    {
+        if (('%' != *p_format) || ('\0' == p_format[1]))
+        {
+            p_buffer[count++] = *p_format++;
+            continue;
+        }
+
+        char const * p_spec = p_format++;
+        bool is_left = false;
+        bool is_zero = false;
+        uint32_t width = 0;
+        for (; ('-' == *p_format) || ('0' == *p_format); p_format++)
+        {
+            is_left |= ('-' == *p_format);
+            is_zero |= ('0' == *p_format);
+        }
+
+        for (; ('0' <= *p_format) && ('9' >= *p_format); p_format++)
+        {
+            width = (width * 10) + (*p_format - '0');
+        }
+
+        // Numbers are written out in full first, then padded as they are copied across.
+        char field[FORMAT_FIELD_SIZE];
+        char const * p_field = field;
+        uint32_t field_size;
+        char conversion = *p_format;
+        if ('\0' != conversion)
+        {
+            p_format++;
+        }
+
+        switch (conversion)
+        {
+            case 's':
+            {
+                p_field = va_arg(args, char const *);
+                field_size = strlen(p_field);
+                is_zero = false;
+                break;
+            }
+            case 'u':
+            {
+                field_size = format_decimal(field, va_arg(args, uint32_t), 1);
+                break;
+            }
+            case 'd':
+            {
+                int32_t value = va_arg(args, int32_t);
+                field[0] = '-';
+                field_size = (0 > value) ? format_decimal(&field[1], -(uint32_t)value, 1) + 1 :
+                                           format_decimal(field, value, 1);
+                break;
+            }
+            case 'x':
+            {
+                field_size = format_hex(field, va_arg(args, uint32_t), 1);
+                break;
+            }
+            case '%':
+            {
+                field_size = 1;
+                field[0] = '%';
+                break;
+            }
+            default:
+            {
+                // Not one of ours, so show it as it was written.
+                p_field = p_spec;
+                field_size = p_format - p_spec;
+                width = 0;
+                break;
+            }
+        }
+
+        uint32_t pad = (width > field_size) ? (width - field_size) : 0;
+        if (is_zero && !is_left && ('-' == p_field[0]) && (0 < pad))
+        {
+            // The sign goes before the zeros.
+            p_buffer[count++] = *p_field++;
+            field_size--;
+        }
+
+        for (; !is_left && (0 < pad) && ((count + 1) < size); pad--)
+        {
+            p_buffer[count++] = is_zero ? '0' : ' ';
+        }
+
+        for (uint32_t i = 0; (i < field_size) && ((count + 1) < size); i++)
+        {
+            p_buffer[count++] = p_field[i];
+        }
+
+        for (; (0 < pad) && ((count + 1) < size); pad--)
+        {
+            p_buffer[count++] = ' ';
+        }
+    }
+
+    if (0 < size)
+    {
+        p_buffer[count] = '\0';
+    }
+
+    return count;
+}
+
+
+static uint32_t format_div10(uint32_t value)
+{
+    // 0xCCCCCCCD / 2^35 is close enough to 1/10 that this is exact for every 32 bit value.
+    return (uint32_t)(((uint64_t)value * 0xCCCCCCCDUL) >> 35);
+}
+
+
+static uint32_t format_hex(char * p_buffer, uint32_t value, uint32_t min_width)
+{
+    uint32_t count = 1;
+    while ((count < 8) && (0 != (value >> (count * 4))))
+    {
+        count++;
+    }
+
+    count = (min_width > count) ? min_width : count;
+    for (uint32_t i = count; 0 < i; i--)
+    {
+        p_buffer[i - 1] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    }
+
+    p_buffer[count] = '\0';
+    return count;
+}
+
+/** @} */
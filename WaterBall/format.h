@@ -0,0 +1,114 @@
+/**
+ * @file
+ * @defgroup WaterBall format.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall number formatting module.
+ *
+ * Small replacements for snprintf for the few formats that the serial port and the
+ * seven segment displays use. The Cortex-M0 has no divide instruction, so dividing
+ * by ten is done with a fixed point multiply instead of calling the library divide.
+ *
+ * Every function writes a terminating zero after the characters, and returns the
+ * number of characters written without it.
+ *
+ * format_vstring covers the printf formats the shell uses, so that newlib's formatter
+ * isn't linked in at all.
+ */
+
+#ifndef FORMAT_H__
+#define FORMAT_H__
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#define FORMAT_DECIMAL_MAX_DIGITS       (10)        /**< The most digits in a uint32_t. */
+#define FORMAT_TIME_SIZE                (5)         /**< "mm:ss" or "ss.cc" */
+#define FORMAT_OVERFLOW_CHAR            '-'         /**< Fills a field that is too small for its value. */
+#define FORMAT_FIELD_SIZE               (FORMAT_DECIMAL_MAX_DIGITS + 2)     /**< A sign, the digits and the terminating zero. */
+
+/**
+ * @brief   The ways of showing a time.
+ */
+typedef enum
+{
+    FORMAT_TIME_MM_SS,                  /**< Minutes and seconds, "mm:ss". */
+    FORMAT_TIME_SS_CC                   /**< Seconds and hundredths of a second, "ss.cc". */
+} format_time_t;
+
+/**
+ * @brief   Write a number in decimal, like "%0*u".
+ *
+ * @param[out]  p_buffer        Where to write, it must have room for FORMAT_DECIMAL_MAX_DIGITS + 1 characters.
+ * @param[in]   value           The number to write.
+ * @param[in]   min_width       The number is padded with leading zeros to at least this many digits.
+ *
+ * @retval      The number of characters written.
+ */
+uint32_t format_decimal(char * p_buffer, uint32_t value, uint32_t min_width);
+
+/**
+ * @brief   Write a score in a fixed number of digits.
+ *
+ * @param[out]  p_buffer        Where to write, it must have room for width + 1 characters.
+ * @param[in]   score           The score to write.
+ * @param[in]   width           The number of digits, the score is padded with leading zeros. A score
+ *                              that doesn't fit is shown as all FORMAT_OVERFLOW_CHAR.
+ *
+ * @retval      The number of characters written, always width.
+ */
+uint32_t format_score(char * p_buffer, uint32_t score, uint32_t width);
+
+/**
+ * @brief   Write a time as "mm:ss" or "ss.cc".
+ *
+ * @details A time that is too big for the format (100 minutes or 100 seconds) is shown as
+ *          all FORMAT_OVERFLOW_CHAR, with the separator.
+ *
+ * @param[out]  p_buffer        Where to write, it must have room for FORMAT_TIME_SIZE + 1 characters.
+ * @param[in]   ms              The time to write.
+ * @param[in]   format          How to write it.
+ *
+ * @retval      The number of characters written, always FORMAT_TIME_SIZE.
+ */
+uint32_t format_time(char * p_buffer, uint32_t ms, format_time_t format);
+
+/**
+ * @brief   Write a printf style format into a buffer, like vsnprintf.
+ *
+ * @details Only %s, %u, %d, %x and %% are understood, with the '-' and '0' flags and a
+ *          width. Anything else is copied out as it is. The text is cut short, rather than
+ *          overflowing, if it doesn't fit.
+ *
+ * @param[out]  p_buffer        Where to write.
+ * @param[in]   size            The size of the buffer, including the terminating zero.
+ * @param[in]   p_format        The format.
+ * @param[in]   args            The arguments for the format.
+ *
+ * @retval      The number of characters written.
+ */
+uint32_t format_vstring(char * p_buffer, uint32_t size, char const * p_format, va_list args);
+
+/**
+ * @brief   Divide by ten with a multiply, exact for every uint32_t.
+ *
+ * @param[in]   value           The number to divide.
+ *
+ * @retval      value / 10
+ */
+static uint32_t format_div10(uint32_t value);
+
+/**
+ * @brief   Write a number in hexadecimal, like "%0*x".
+ *
+ * @param[out]  p_buffer        Where to write, it must have room for FORMAT_FIELD_SIZE characters.
+ * @param[in]   value           The number to write.
+ * @param[in]   min_width       The number is padded with leading zeros to at least this many digits.
+ *
+ * @retval      The number of characters written.
+ */
+static uint32_t format_hex(char * p_buffer, uint32_t value, uint32_t min_width);
+
+#endif //FORMAT_H__
+
+/** @} */
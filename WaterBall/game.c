@@ -1,348 +1,492 @@
-/**
- * @file
- * @defgroup WaterBall game.c
- * @{
- * @ingroup WaterBall
- * @brief WaterBall game module.
- */
-
-#include <string.h>
-
-#include "app_button.h"
-#include "app_error.h"
-#include "bsp.h"
-#include "clock.h"
-#include "game.h"
-#include "serial.h"
-#include "service.h"
-#include "service_client.h"
-#include "service_server.h"
-#include "seven_segment.h"
-
-static game_state_t         m_game_state;
-static uint32_t             m_my_score;
-static uint32_t             m_their_score;
-static uint32_t             m_game_time = 60000;
-static uint32_t             m_game_init_ticks;
-static uint32_t             m_game_start_ticks;
-static uint32_t             m_water_start_ticks;
-
-
-void game_event_handler(uint8_t pin_number, uint8_t button_action)
-{
-    if (APP_BUTTON_RELEASE == button_action)
-    {
-        return;
-    }
-
-    switch (pin_number)
-    {
-        case BUTTON_2:
-            if (GAME_STATE_WAITING == m_game_state)
-            {
-                // Start the game if we are waiting.
-                m_game_state = GAME_STATE_INITIALIZING_GAME;
-            }
-            else
-            {
-                // Otherwise stop the game.
-                m_game_state = GAME_STATE_INIT;
-            }
-
-            break;
-        case BUTTON_3:
-            if (GAME_STATE_PLAYING == m_game_state)
-            {
-                game_increment_my_score(1);
-            }
-
-            break;
-        case BUTTON_4:
-        {
-            if ((GAME_STATE_WAITING == m_game_state) && IS_SERVICE_SERVER)
-            {
-                // Start the game if we are waiting.
-                m_game_state = GAME_STATE_INITIALIZING_GAME;
-            }
-            else if (GAME_STATE_PLAYING == m_game_state)
-            {
-                game_set_my_score(MAX_SCORE);
-            }
-            else
-            {
-                // Otherwise stop the game.
-                m_game_state = GAME_STATE_INIT;
-            }
-
-            break;
-        }
-        default:
-            break;
-    }
-}
-
-
-void game_init(void)
-{
-    m_game_state = GAME_STATE_INIT;
-}
-
-
-void game_tasks(void)
-{
-    uint32_t my_score = game_get_my_score();
-    uint32_t their_score = game_get_their_score();
-
-    switch (m_game_state)
-    {
-        case GAME_STATE_INIT:
-        {
-            if (IS_SERVICE_SERVER)
-            {
-                service_server_indicate_game_state(GAME_STATE_INIT);
-            }
-
-            LEDS_ON(BSP_LED_3_MASK);
-            seven_segment_blank_digits(TIME_ADDRESS);
-            seven_segment_blank_digits(SCORE_ADDRESS);
-            m_game_state = GAME_STATE_WAITING;
-            break;
-        }
-        case GAME_STATE_WAITING:
-        {
-            break;
-        }
-        case GAME_STATE_INITIALIZING_GAME:
-        {
-            if (IS_SERVICE_SERVER)
-            {
-                service_server_indicate_game_state(GAME_STATE_INITIALIZING_GAME);
-            }
-
-            m_game_init_ticks = clock_get_ticks();
-            game_set_my_score(0);
-            m_game_state = GAME_STATE_COUNTING_DOWN;
-            break;
-        }
-        case GAME_STATE_WAITING_TO_COUNT_DOWN:
-        {
-            break;
-        }
-        case GAME_STATE_COUNTING_DOWN:
-        {
-            uint32_t count_down_ticks = CLOCK_MS_IN_TICKS(5000);
-            uint32_t ms = clock_ms_until(m_game_init_ticks, count_down_ticks);
-            if (clock_ticks_have_passed(m_game_init_ticks, count_down_ticks))
-            {
-                m_game_state = GAME_STATE_START;
-            }
-
-            game_print_start(ms);
-            break;
-        }
-        case GAME_STATE_START:
-        {
-            m_game_start_ticks = clock_get_ticks();
-            m_game_state = GAME_STATE_PLAYING;
-            break;
-        }
-        case GAME_STATE_PLAYING:
-        {
-            // Time
-            uint32_t play_ticks = CLOCK_MS_IN_TICKS(m_game_time);
-            uint32_t ms = clock_ms_until(m_game_start_ticks, play_ticks);
-            if (clock_ticks_have_passed(m_game_start_ticks, play_ticks))
-            {
-                m_game_state = GAME_STATE_GAME_OVER;
-            }
-
-            game_print_time(ms, TIME_SCALE_AUTO);
-
-            // Score
-            game_print_score(my_score, their_score);
-
-            if ((MAX_SCORE == my_score) || (MAX_SCORE == their_score))
-            {
-                m_game_state = GAME_STATE_GAME_OVER;
-            }
-
-            break;
-        }
-        case GAME_STATE_GAME_OVER:
-        {
-            game_print_end(my_score, their_score);
-
-            m_water_start_ticks = clock_get_ticks();
-            m_game_state = GAME_STATE_WATER;
-            if (my_score >= their_score)
-            {
-                // Always go to the water state, but only turn on the led if we lost.
-                LEDS_OFF(BSP_LED_3_MASK);
-            }
-
-            break;
-        }
-        case GAME_STATE_WATER:
-        {
-            uint32_t water_ticks = CLOCK_MS_IN_TICKS(7000);
-            if (clock_ticks_have_passed(m_water_start_ticks, water_ticks))
-            {
-                LEDS_ON(BSP_LED_3_MASK);
-                m_game_state = GAME_STATE_INIT;
-            }
-
-            break;
-        }
-        case GAME_STATE_ERROR:
-        {
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-uint32_t game_get_game_time(void)
-{
-    uint32_t game_time = 0;
-
-    if (IS_SERVICE_SERVER)
-    {
-        game_time = service_server_get_game_time();
-    }
-    else if (IS_SERVICE_CLIENT)
-    {
-        game_time = service_client_get_game_time();
-    }
-
-    return game_time;
-}
-
-
-uint32_t game_get_my_score(void)
-{
-    return m_my_score;
-}
-
-
-void game_set_my_score(uint32_t score)
-{
-    m_my_score = score;
-    if (IS_SERVICE_SERVER)
-    {
-        service_server_indicate_server_score(m_my_score);
-    }
-    else if (IS_SERVICE_CLIENT)
-    {
-        service_client_write_client_score(m_my_score);
-    }
-}
-
-
-uint32_t game_increment_my_score(uint32_t points)
-{
-    uint32_t new_score = (MAX_SCORE - m_my_score) > points ? m_my_score + points : MAX_SCORE;
-    game_set_my_score(new_score);
-    return m_my_score;
-}
-
-
-uint32_t game_get_their_score(void)
-{
-    if (IS_SERVICE_SERVER)
-    {
-        m_their_score = service_server_get_client_score();
-    }
-    else if (IS_SERVICE_CLIENT)
-    {
-        m_their_score = service_client_get_server_score();
-    }
-
-    return m_their_score;
-}
-
-
-void game_set_state(game_state_t state)
-{
-    m_game_state = state;
-}
-
-
-static void game_print_start(uint32_t ms)
-{
-    char count_string[] = "4321";
-    int i = 5 - (ms / 1000);
-    count_string[MIN(i, strlen(count_string))] = '\0';
-    seven_segment_set_char_digits(TIME_ADDRESS, 0, count_string, COLON_TYPE_NONE);
-    if (5 <= i)
-    {
-        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "PLAY", COLON_TYPE_NONE);
-    }
-}
-
-
-static void game_print_score(uint32_t my_score, uint32_t their_score)
-{
-    static char buffer[BUFFER_LEN] = { 0 };
-
-    uint32_t size = snprintf(buffer, sizeof(buffer), "\t%02d %02d", my_score, their_score);
-    serial_write((uint8_t *)buffer, size);
-
-    seven_segment_set_numbers(SCORE_ADDRESS, my_score, their_score, COLON_TYPE_NONE);
-}
-
-
-static void game_print_time(uint32_t ms, time_scale_t time_scale)
-{
-    static char buffer[BUFFER_LEN] = { 0 };
-
-    uint32_t total_seconds = ms / 1000;
-    uint32_t left_time = total_seconds / 60;
-    uint32_t right_time = total_seconds % 60;
-
-    if (60 > total_seconds)
-    {
-        left_time = right_time;
-        right_time = (ms % 1000) / 10;
-    }
-
-    switch (time_scale)
-    {
-        case TIME_SCALE_MILLISECOND:
-            left_time = total_seconds % 60;
-            right_time = (ms % 1000) / 10;
-            break;
-        case TIME_SCALE_SECOND:
-            left_time = total_seconds / 60;
-            right_time = total_seconds % 60;
-            break;
-        default:
-            break;
-    }
-
-    uint32_t size = snprintf(buffer, sizeof(buffer), "\r\t%02d:%02d", left_time, right_time);
-    serial_write((uint8_t *)buffer, size);
-
-    seven_segment_set_numbers(TIME_ADDRESS, left_time, right_time, COLON_TYPE_COLON);
-}
-
-
-static void game_print_end(uint32_t my_score, uint32_t their_score)
-{
-    if (my_score >= their_score)
-    {
-        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "FAIL", COLON_TYPE_NONE);
-        seven_segment_set_char_digits(TIME_ADDRESS, 0, "FAIL", COLON_TYPE_NONE);
-    }
-    else
-    {
-        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "PASS", COLON_TYPE_NONE);
-        seven_segment_set_char_digits(TIME_ADDRESS, 0, "PASS", COLON_TYPE_NONE);
-    }
-}
-
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall game.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall game module.
+ */
+
+#include <string.h>
+
+#include "app_button.h"
+#include "app_error.h"
+#include "app_util.h"
+#include "bsp.h"
+#include "buttons.h"
+#include "clock.h"
+#include "format.h"
+#include "game.h"
+#include "log.h"
+#include "ring.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "service.h"
+#include "service_client.h"
+#include "service_server.h"
+#include "seven_segment.h"
+#include "telemetry.h"
+#include "timers.h"
+
+RING_DEF(m_press_queue, sizeof(game_button_event_t), GAME_PRESS_QUEUE_SIZE);
+
+static game_state_t         m_game_state;
+static uint32_t             m_my_score;
+static uint32_t             m_their_score;
+static uint32_t             m_game_time = 60000;
+static timers_timer_t       m_phase_timer;          // Times the count down, the game and the water.
+static timers_timer_t       m_refresh_timer;        // Steps the count down, then refreshes the time on the display.
+static uint64_t             m_start_ticks;          // When play starts, 0 until it is set.
+static uint32_t             m_start_late_us;
+static uint64_t             m_play_start_us;        // When the start was noticed, m_start_late_us after it, on the high resolution time.
+static uint32_t             m_last_press_us;        // From the start of play to the last press.
+static game_reaction_t      m_reaction;
+
+
+void game_event_handler(uint8_t pin_number, uint8_t button_action)
+{
+    // Only note the press here, the state and the scores are changed by game_tasks. The
+    // release of the score button is needed too, to start capturing its next press.
+    if ((APP_BUTTON_RELEASE == button_action) && (BUTTONS_TIMESTAMP_PIN != pin_number))
+    {
+        return;
+    }
+
+    game_button_event_t event = { pin_number, button_action };
+    if (0 == ring_write(&m_press_queue, &event, 1))
+    {
+        LOG1(LOG_GAME_BUTTON_DROPPED, pin_number);
+    }
+
+    scheduler_set_pending(SCHEDULER_MODULE_GAME);
+}
+
+
+void game_init(void)
+{
+    m_game_state = GAME_STATE_INIT;
+    m_start_ticks = 0;
+    timers_create(&m_phase_timer, timers_pending_handler, (void *)SCHEDULER_MODULE_GAME);
+    timers_create(&m_refresh_timer, timers_pending_handler, (void *)SCHEDULER_MODULE_GAME);
+}
+
+
+void game_tasks(void)
+{
+    game_state_t state = m_game_state;
+
+    game_button_event_t event;
+    while (0 < ring_read(&m_press_queue, &event, 1))
+    {
+        if (APP_BUTTON_RELEASE == event.button_action)
+        {
+            buttons_timestamps_rearm();
+        }
+        else
+        {
+            game_handle_press(event.pin_number);
+        }
+    }
+
+    uint32_t my_score = game_get_my_score();
+    uint32_t their_score = game_get_their_score();
+
+    switch (m_game_state)
+    {
+        case GAME_STATE_INIT:
+        {
+            if (IS_SERVICE_SERVER)
+            {
+                service_server_indicate_game_state(GAME_STATE_INIT, 0);
+            }
+
+            m_start_ticks = 0;
+            timers_stop(&m_phase_timer);
+            timers_stop(&m_refresh_timer);
+            buttons_timestamps_disable();
+            LEDS_ON(BSP_LED_3_MASK);
+            seven_segment_blank_digits(TIME_ADDRESS);
+            seven_segment_blank_digits(SCORE_ADDRESS);
+            m_game_state = GAME_STATE_WAITING;
+            break;
+        }
+        case GAME_STATE_WAITING:
+        {
+            break;
+        }
+        case GAME_STATE_INITIALIZING_GAME:
+        {
+            // A start that has passed or is further off than a count down means the clocks
+            // aren't known well enough, so count down from now instead.
+            uint64_t now_ticks = clock_get_ticks64();
+            if ((m_start_ticks <= now_ticks) ||
+                (m_start_ticks > (now_ticks + CLOCK_MS_IN_TICKS(GAME_COUNT_DOWN_MS))))
+            {
+                m_start_ticks = now_ticks + CLOCK_MS_IN_TICKS(GAME_COUNT_DOWN_MS);
+            }
+
+            if (IS_SERVICE_SERVER)
+            {
+                service_server_indicate_game_state(GAME_STATE_INITIALIZING_GAME, (uint32_t)m_start_ticks);
+            }
+
+            // The steps are lined up with the start rather than with now, so that they change
+            // at the same moment on both sides.
+            timers_start_at(&m_phase_timer, m_start_ticks, 0);
+            timers_start_at(&m_refresh_timer,
+                            m_start_ticks - ((GAME_COUNT_DOWN_STEPS - 1) * CLOCK_MS_IN_TICKS(GAME_COUNT_DOWN_STEP_MS)),
+                            GAME_COUNT_DOWN_STEP_MS);
+            game_set_my_score(0);
+            m_game_state = GAME_STATE_COUNTING_DOWN;
+            break;
+        }
+        case GAME_STATE_WAITING_TO_COUNT_DOWN:
+        {
+            break;
+        }
+        case GAME_STATE_COUNTING_DOWN:
+        {
+            uint64_t now_ticks = clock_get_ticks64();
+            if (!timers_is_running(&m_phase_timer))
+            {
+                m_game_state = GAME_STATE_START;
+            }
+
+            game_print_start((m_start_ticks > now_ticks) ? (uint32_t)(m_start_ticks - now_ticks) : 0);
+            break;
+        }
+        case GAME_STATE_START:
+        {
+            // Only presses from now on are timestamped, so a press during the count down doesn't
+            // count. The high resolution time is read next to the clock, so the reaction times
+            // can be measured from the agreed start rather than from now.
+            buttons_timestamps_enable();
+            m_play_start_us = clock_hf_get_us64();
+            m_start_late_us = (uint32_t)CLOCK_TICKS_IN_US(clock_get_ticks64() - m_start_ticks);
+            LOG1(LOG_GAME_START, m_start_late_us);
+
+            // The end is lined up with the start too.
+            timers_start_at(&m_phase_timer, m_start_ticks + CLOCK_MS_IN_TICKS(m_game_time), 0);
+            timers_start(&m_refresh_timer, GAME_PERIOD_MS, GAME_PERIOD_MS);
+
+            memset(&m_reaction, 0, sizeof(m_reaction));
+            m_reaction.fastest_us = UINT32_MAX;
+            m_game_state = GAME_STATE_PLAYING;
+            break;
+        }
+        case GAME_STATE_PLAYING:
+        {
+            // The refresh timer brings us here well within a wrap of the high resolution time.
+            buttons_timestamps_poll();
+
+            // Time
+            uint32_t ms = timers_ms_until(&m_phase_timer);
+            if (!timers_is_running(&m_phase_timer))
+            {
+                m_game_state = GAME_STATE_GAME_OVER;
+            }
+
+            game_print_time(ms, TIME_SCALE_AUTO);
+
+            // Score
+            game_print_score(my_score, their_score);
+
+            telemetry_send_game(m_game_state, my_score, their_score, ms);
+
+            if ((MAX_SCORE == my_score) || (MAX_SCORE == their_score))
+            {
+                m_game_state = GAME_STATE_GAME_OVER;
+            }
+
+            break;
+        }
+        case GAME_STATE_GAME_OVER:
+        {
+            game_print_end(my_score, their_score);
+            LOG2(LOG_GAME_OVER, my_score, their_score);
+            LOG3(LOG_GAME_REACTION, m_reaction.presses, m_reaction.first_us, m_reaction.fastest_us);
+            buttons_timestamps_disable();
+
+            timers_stop(&m_refresh_timer);
+            timers_start(&m_phase_timer, GAME_WATER_MS, 0);
+            m_game_state = GAME_STATE_WATER;
+            if (my_score >= their_score)
+            {
+                // Always go to the water state, but only turn on the led if we lost.
+                LEDS_OFF(BSP_LED_3_MASK);
+            }
+
+            break;
+        }
+        case GAME_STATE_WATER:
+        {
+            if (!timers_is_running(&m_phase_timer))
+            {
+                LEDS_ON(BSP_LED_3_MASK);
+                m_game_state = GAME_STATE_INIT;
+            }
+
+            break;
+        }
+        case GAME_STATE_ERROR:
+        {
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    // Run again right away if the state changed, the timers wake us up for everything else.
+    if (state != m_game_state)
+    {
+        LOG2(LOG_GAME_STATE, state, m_game_state);
+        scheduler_set_pending(SCHEDULER_MODULE_GAME);
+    }
+}
+
+
+uint32_t game_get_game_time(void)
+{
+    uint32_t game_time = 0;
+
+    if (IS_SERVICE_SERVER)
+    {
+        game_time = service_server_get_game_time();
+    }
+    else if (IS_SERVICE_CLIENT)
+    {
+        game_time = service_client_get_game_time();
+    }
+
+    return game_time;
+}
+
+
+uint32_t game_get_my_score(void)
+{
+    return m_my_score;
+}
+
+
+void game_set_my_score(uint32_t score)
+{
+    m_my_score = score;
+    if (IS_SERVICE_SERVER)
+    {
+        service_server_indicate_server_score(m_my_score);
+    }
+    else if (IS_SERVICE_CLIENT)
+    {
+        service_client_write_client_score(m_my_score);
+    }
+}
+
+
+uint32_t game_increment_my_score(uint32_t points)
+{
+    uint32_t new_score = (MAX_SCORE - m_my_score) > points ? m_my_score + points : MAX_SCORE;
+    game_set_my_score(new_score);
+    return m_my_score;
+}
+
+
+uint32_t game_get_their_score(void)
+{
+    if (IS_SERVICE_SERVER)
+    {
+        m_their_score = service_server_get_client_score();
+    }
+    else if (IS_SERVICE_CLIENT)
+    {
+        m_their_score = service_client_get_server_score();
+    }
+
+    return m_their_score;
+}
+
+
+void game_set_state(game_state_t state)
+{
+    m_game_state = state;
+}
+
+
+void game_set_start_ticks(uint64_t start_ticks)
+{
+    m_start_ticks = start_ticks;
+}
+
+
+bool game_is_playing(void)
+{
+    return GAME_STATE_PLAYING == m_game_state;
+}
+
+
+uint32_t game_get_start_late_us(void)
+{
+    return m_start_late_us;
+}
+
+
+game_reaction_t const * game_get_reaction(void)
+{
+    return &m_reaction;
+}
+
+
+static void game_record_press(uint64_t press_us)
+{
+    // A press can land between turning the timestamps on and reading the start.
+    uint64_t press_late_us = press_us + m_start_late_us;
+    uint32_t since_start_us = (press_late_us > m_play_start_us) ? (uint32_t)(press_late_us - m_play_start_us) : 0;
+    if (0 == m_reaction.presses)
+    {
+        m_reaction.first_us = since_start_us;
+    }
+    else
+    {
+        m_reaction.fastest_us = MIN(m_reaction.fastest_us, since_start_us - m_last_press_us);
+    }
+
+    m_last_press_us = since_start_us;
+    m_reaction.presses++;
+}
+
+
+static void game_handle_press(uint8_t pin_number)
+{
+    LOG2(LOG_GAME_BUTTON, pin_number, m_game_state);
+
+    switch (pin_number)
+    {
+        case BUTTON_2:
+            if (GAME_STATE_WAITING == m_game_state)
+            {
+                // Start the game if we are waiting.
+                m_game_state = GAME_STATE_INITIALIZING_GAME;
+            }
+            else
+            {
+                // Otherwise stop the game.
+                m_game_state = GAME_STATE_INIT;
+            }
+
+            break;
+        case BUTTON_3:
+            if (GAME_STATE_PLAYING == m_game_state)
+            {
+                // The press was timestamped by the hardware, it doesn't matter how long it took us to get here.
+                uint64_t press_us;
+                if (buttons_take_press_us(&press_us))
+                {
+                    game_record_press(press_us);
+                }
+
+                game_increment_my_score(1);
+            }
+
+            break;
+        case BUTTON_4:
+        {
+            if ((GAME_STATE_WAITING == m_game_state) && IS_SERVICE_SERVER)
+            {
+                // Start the game if we are waiting.
+                m_game_state = GAME_STATE_INITIALIZING_GAME;
+            }
+            else if (GAME_STATE_PLAYING == m_game_state)
+            {
+                game_set_my_score(MAX_SCORE);
+            }
+            else
+            {
+                // Otherwise stop the game.
+                m_game_state = GAME_STATE_INIT;
+            }
+
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+
+static void game_print_start(uint32_t ticks)
+{
+    // A step shows from the tick of its boundary on, which is the tick the refresh timer expires on.
+    char count_string[] = "4321";
+    int i = GAME_COUNT_DOWN_STEPS + 1 - CEIL_DIV(MAX(ticks, 1), CLOCK_MS_IN_TICKS(GAME_COUNT_DOWN_STEP_MS));
+    count_string[MIN(i, strlen(count_string))] = '\0';
+    seven_segment_set_char_digits(TIME_ADDRESS, 0, count_string, COLON_TYPE_NONE);
+    if (GAME_COUNT_DOWN_STEPS <= i)
+    {
+        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "PLAY", COLON_TYPE_NONE);
+    }
+}
+
+
+static void game_print_score(uint32_t my_score, uint32_t their_score)
+{
+    static char buffer[BUFFER_LEN] = { 0 };
+
+    if (TELEMETRY_MODE_TEXT == telemetry_get_mode())
+    {
+        uint32_t size = 0;
+        buffer[size++] = '\t';
+        size += format_decimal(&buffer[size], my_score, 2);
+        buffer[size++] = ' ';
+        size += format_decimal(&buffer[size], their_score, 2);
+        serial_write((uint8_t *)buffer, size);
+    }
+
+    seven_segment_set_numbers(SCORE_ADDRESS, my_score, their_score, COLON_TYPE_NONE);
+}
+
+
+static void game_print_time(uint32_t ms, time_scale_t time_scale)
+{
+    static char buffer[BUFFER_LEN] = { 0 };
+
+    format_time_t format = FORMAT_TIME_MM_SS;
+    if ((TIME_SCALE_MILLISECOND == time_scale) ||
+        ((TIME_SCALE_AUTO == time_scale) && (60000 > ms)))
+    {
+        // Show the hundredths of a second for the last minute.
+        format = FORMAT_TIME_SS_CC;
+    }
+
+    uint32_t size = 0;
+    buffer[size++] = '\r';
+    buffer[size++] = '\t';
+    char * p_time = &buffer[size];
+    size += format_time(p_time, ms, format);
+
+    if (TELEMETRY_MODE_TEXT == telemetry_get_mode())
+    {
+        serial_write((uint8_t *)buffer, size);
+    }
+
+    // The display has the colon between the digits, so skip over the separator.
+    char digits[] = { p_time[0], p_time[1], p_time[3], p_time[4], '\0' };
+    seven_segment_set_char_digits(TIME_ADDRESS, 0, digits, COLON_TYPE_COLON);
+}
+
+
+static void game_print_end(uint32_t my_score, uint32_t their_score)
+{
+    if (my_score >= their_score)
+    {
+        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "FAIL", COLON_TYPE_NONE);
+        seven_segment_set_char_digits(TIME_ADDRESS, 0, "FAIL", COLON_TYPE_NONE);
+    }
+    else
+    {
+        seven_segment_set_char_digits(SCORE_ADDRESS, 0, "PASS", COLON_TYPE_NONE);
+        seven_segment_set_char_digits(TIME_ADDRESS, 0, "PASS", COLON_TYPE_NONE);
+    }
+}
+
+
+/** @} */
@@ -1,123 +1,203 @@
-/**
- * @file
- * @defgroup WaterBall game.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall game module.
- *
- * Main interface for the game.
- */
-
-#ifndef GAME_H__
-#define GAME_H__
-
-#include <stdbool.h>
-#include <stdint.h>
-#include "ble.h"
-#include "ble_types.h"
-
-#define BUFFER_LEN              (128)
-#define MAX_SCORE               (UINT32_MAX)
-
-/**
- * @brief   service server module states.
- */
-typedef enum
-{
-    GAME_STATE_INIT = 0,                /**< Initialize the service server module. */
-    GAME_STATE_WAITING,                 /**< The service server module is just waiting for a game to start. */
-    GAME_STATE_INITIALIZING_GAME,       /**< A game has been requested to start to make sure we have all the correct value. */
-    GAME_STATE_WAITING_TO_COUNT_DOWN,   /**< We may have to wait before we can count down to the start. */
-    GAME_STATE_COUNTING_DOWN,           /**< Count down until the start of the game. */
-    GAME_STATE_START,                   /**< Display that we can now start. */
-    GAME_STATE_PLAYING,                 /**< We are now playing the game. */
-    GAME_STATE_GAME_OVER,               /**< The game is over. */
-    GAME_STATE_WATER,                   /**< The loser gets squirted. */
-    GAME_STATE_TIME_UP,                 /**< Time is up, decide who gets wet. */
-    GAME_STATE_MAX_SCORE,               /**< Some one reached the max score, so figure out who gets wet. */
-    GAME_STATE_ERROR                    /**< Throw an error message if it occurred in the interrupt handler. */
-} game_state_t;
-
-typedef enum
-{
-    TIME_SCALE_AUTO,                    /**< Use whatever time scale makes sense. */
-    TIME_SCALE_MILLISECOND,             /**< Milliseconds will be in the lowest order place. */
-    TIME_SCALE_SECOND                   /**< Seconds will be in the lowest order place. */
-} time_scale_t;
-
-/**
- * @brief   Event handler that runs when a button is pressed.
- *
- * @param[in]   pin_number      The number of the pin that was pressed.
- * @param[in]   button_action   The action (press or release) of the button.
- */
-void game_event_handler(uint8_t pin_number, uint8_t button_action);
-
-/**
- * @brief   Function to initialize the game module.
- */
-void game_init(void);
-
-/**
- * @brief   Function to accomplish game module tasks.
- *
- * @details This should be called repeatedly from the main loop.
- */
-void game_tasks(void);
-
-/**
- * @brief   Function to get the game time.
- *
- * @retval      The game time.
- */
-uint32_t game_get_game_time(void);
-
-/**
- * @brief   Function to get my score.
- *
- * @retval      My current score.
- */
-uint32_t game_get_my_score(void);
-
-/**
- * @brief   Function to set my score.
- *
- * @param[in]   score       My new score.
- */
-void game_set_my_score(uint32_t score);
-
-/**
- * @brief   Function to set increment score.
- *
- * @param[in]   points      How many points to increment my score by.
- *
- * @retval      My new current score.
- */
-uint32_t game_increment_my_score(uint32_t points);
-
-/**
- * @brief   Function to get their score.
- *
- * @retval      Their current score.
- */
-uint32_t game_get_their_score(void);
-
-void game_set_state(game_state_t state);
-
-static void game_print_start(uint32_t ms);
-
-static void game_print_score(uint32_t my_score, uint32_t their_score);
-
-/**
- * @brief   Function to print the time on the seven segment display.
- *
- * @param[in]   ms          The number of milliseconds into the game.
- * @param[in]   time_scale  The 
- */
-static void game_print_time(uint32_t ms, time_scale_t time_scale);
-
-static void game_print_end(uint32_t my_score, uint32_t their_score);
-
-#endif //GAME_H__
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall game.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall game module.
+ *
+ * Main interface for the game.
+ */
+
+#ifndef GAME_H__
+#define GAME_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ble.h"
+#include "ble_types.h"
+
+#define BUFFER_LEN              (128)
+#define MAX_SCORE               (UINT32_MAX)
+#define GAME_PERIOD_MS          (10)            /**< How often the display is refreshed while it shows a time. */
+#define GAME_COUNT_DOWN_MS      (5000)
+#define GAME_COUNT_DOWN_STEP_MS (1000)          /**< The count down display changes on every whole second before the start. */
+#define GAME_COUNT_DOWN_STEPS   (GAME_COUNT_DOWN_MS / GAME_COUNT_DOWN_STEP_MS)
+#define GAME_WATER_MS           (7000)          /**< How long the loser gets squirted for. */
+#define GAME_DEADLINE_MS        (10)            /**< How long a button press or state change can wait before the game runs. */
+#define GAME_PRESS_QUEUE_SIZE   (8)             /**< Button events that can wait for the game to run, must be a power of two. */
+
+/**
+ * @brief   service server module states.
+ */
+typedef enum
+{
+    GAME_STATE_INIT = 0,                /**< Initialize the service server module. */
+    GAME_STATE_WAITING,                 /**< The service server module is just waiting for a game to start. */
+    GAME_STATE_INITIALIZING_GAME,       /**< A game has been requested to start to make sure we have all the correct value. */
+    GAME_STATE_WAITING_TO_COUNT_DOWN,   /**< We may have to wait before we can count down to the start. */
+    GAME_STATE_COUNTING_DOWN,           /**< Count down until the start of the game. */
+    GAME_STATE_START,                   /**< Display that we can now start. */
+    GAME_STATE_PLAYING,                 /**< We are now playing the game. */
+    GAME_STATE_GAME_OVER,               /**< The game is over. */
+    GAME_STATE_WATER,                   /**< The loser gets squirted. */
+    GAME_STATE_TIME_UP,                 /**< Time is up, decide who gets wet. */
+    GAME_STATE_MAX_SCORE,               /**< Some one reached the max score, so figure out who gets wet. */
+    GAME_STATE_ERROR                    /**< Throw an error message if it occurred in the interrupt handler. */
+} game_state_t;
+
+typedef enum
+{
+    TIME_SCALE_AUTO,                    /**< Use whatever time scale makes sense. */
+    TIME_SCALE_MILLISECOND,             /**< Milliseconds will be in the lowest order place. */
+    TIME_SCALE_SECOND                   /**< Seconds will be in the lowest order place. */
+} time_scale_t;
+
+/**
+ * @brief   A button event queued for game_tasks.
+ */
+typedef struct
+{
+    uint8_t     pin_number;
+    uint8_t     button_action;          /**< APP_BUTTON_PUSH or APP_BUTTON_RELEASE. */
+} game_button_event_t;
+
+/**
+ * @brief   The reaction times of a game, from the hardware timestamps of the score button.
+ */
+typedef struct
+{
+    uint32_t    presses;                /**< The number of timestamped presses. */
+    uint32_t    first_us;               /**< From the start of play to the first press. */
+    uint32_t    fastest_us;             /**< The shortest time between two presses. */
+} game_reaction_t;
+
+/**
+ * @brief   Event handler that runs when a button is pressed.
+ *
+ * @details It runs in the app_button interrupt, so it only queues the press for game_tasks.
+ *
+ * @param[in]   pin_number      The number of the pin that was pressed.
+ * @param[in]   button_action   The action (press or release) of the button.
+ */
+void game_event_handler(uint8_t pin_number, uint8_t button_action);
+
+/**
+ * @brief   Function to initialize the game module.
+ */
+void game_init(void);
+
+/**
+ * @brief   Function to accomplish game module tasks.
+ *
+ * @details This should be called repeatedly from the main loop.
+ */
+void game_tasks(void);
+
+/**
+ * @brief   Function to get the game time.
+ *
+ * @retval      The game time.
+ */
+uint32_t game_get_game_time(void);
+
+/**
+ * @brief   Function to get my score.
+ *
+ * @retval      My current score.
+ */
+uint32_t game_get_my_score(void);
+
+/**
+ * @brief   Function to set my score.
+ *
+ * @param[in]   score       My new score.
+ */
+void game_set_my_score(uint32_t score);
+
+/**
+ * @brief   Function to set increment score.
+ *
+ * @param[in]   points      How many points to increment my score by.
+ *
+ * @retval      My new current score.
+ */
+uint32_t game_increment_my_score(uint32_t points);
+
+/**
+ * @brief   Function to get their score.
+ *
+ * @retval      Their current score.
+ */
+uint32_t game_get_their_score(void);
+
+void game_set_state(game_state_t state);
+
+/**
+ * @brief   Set the moment that play starts, for the next count down.
+ *
+ * @details The client sets this from the start time of the server, before it moves to
+ *          GAME_STATE_INITIALIZING_GAME. Otherwise the count down starts from now.
+ *
+ * @param[in]   start_ticks When play starts, on the 64 bit clock.
+ */
+void game_set_start_ticks(uint64_t start_ticks);
+
+/**
+ * @brief   Test to see if a game is being played.
+ *
+ * @retval      True from the start of play until the game is over.
+ */
+bool game_is_playing(void);
+
+/**
+ * @brief   Get how late the last game started, compared with the time it was meant to.
+ *
+ * @details Along with the error of the sync module, this is how far apart the two sides start.
+ *
+ * @retval      The lateness of the last start in microseconds.
+ */
+uint32_t game_get_start_late_us(void);
+
+/**
+ * @brief   Get the reaction times of the game being played, or of the last one.
+ *
+ * @retval      The reaction times.
+ */
+game_reaction_t const * game_get_reaction(void);
+
+/**
+ * @brief   Add a press of the score button to the reaction times.
+ *
+ * @param[in]   press_us    When the button was pressed, on the high resolution time.
+ */
+static void game_record_press(uint64_t press_us);
+
+/**
+ * @brief   Act on a button press that game_event_handler queued.
+ *
+ * @param[in]   pin_number      The number of the pin that was pressed.
+ */
+static void game_handle_press(uint8_t pin_number);
+
+/**
+ * @brief   Function to print the count down on the seven segment displays.
+ *
+ * @param[in]   ticks       The time until play starts.
+ */
+static void game_print_start(uint32_t ticks);
+
+static void game_print_score(uint32_t my_score, uint32_t their_score);
+
+/**
+ * @brief   Function to print the time on the seven segment display.
+ *
+ * @param[in]   ms          The number of milliseconds into the game.
+ * @param[in]   time_scale  The 
+ */
+static void game_print_time(uint32_t ms, time_scale_t time_scale);
+
+static void game_print_end(uint32_t my_score, uint32_t their_score);
+
+#endif //GAME_H__
+
+/** @} */
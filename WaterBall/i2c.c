@@ -1,10 +1,31 @@
+#include <string.h>
+
 #include "app_util_platform.h"
+#include "clock.h"
 #include "i2c.h"
 #include "nrf_drv_twi.h"
+#include "scheduler.h"
 
 static const nrf_drv_twi_t m_twi_master = NRF_DRV_TWI_INSTANCE(MASTER_TWI_INST);
 
-#define NUM_TRIES                       50
+static i2c_transaction_t    m_queue[I2C_QUEUE_SIZE];
+static uint32_t             m_queue_head;
+static uint32_t             m_queue_count;
+static i2c_device_stats_t   m_device_stats[I2C_MAX_DEVICES];
+static uint32_t             m_dropped_count;
+
+static volatile bool        m_is_busy;                              // A write is being sent by the driver.
+static volatile bool        m_is_done;                              // The driver has finished the write.
+static volatile bool        m_is_success;
+
+
+static void i2c_event_handler(nrf_drv_twi_evt_t const * p_event, void * p_context)
+{
+    m_is_success = (NRF_DRV_TWI_EVT_DONE == p_event->type);
+    m_is_done = true;
+    scheduler_set_pending(SCHEDULER_MODULE_I2C);
+}
+
 
 void i2c_init(void)
 {
@@ -16,35 +37,178 @@ void i2c_init(void)
        .interrupt_priority = APP_IRQ_PRIORITY_HIGH
     };
 
-    APP_ERROR_CHECK(nrf_drv_twi_init(&m_twi_master, &config, NULL, NULL));
+    m_queue_head = 0;
+    m_queue_count = 0;
+    m_dropped_count = 0;
+    m_is_busy = false;
+    m_is_done = false;
+    memset(m_device_stats, 0, sizeof(m_device_stats));
+
+    APP_ERROR_CHECK(nrf_drv_twi_init(&m_twi_master, &config, i2c_event_handler, NULL));
     nrf_drv_twi_enable(&m_twi_master);
 }
 
 
 void i2c_tasks(void)
 {
+    if (m_is_done)
+    {
+        m_is_done = false;
+        m_is_busy = false;
+
+        i2c_transaction_t * p_transaction = &m_queue[m_queue_head];
+        if (m_is_success)
+        {
+            i2c_finish(true);
+        }
+        else
+        {
+            i2c_device_stats(p_transaction->address)->errors++;
+            p_transaction->retry_ticks = clock_get_ticks();
+            if (I2C_MAX_TRIES <= p_transaction->tries)
+            {
+                i2c_device_stats(p_transaction->address)->failures++;
+                i2c_finish(false);
+            }
+        }
+    }
+
+    if (m_is_busy || (0 == m_queue_count))
+    {
+        scheduler_set_period(SCHEDULER_MODULE_I2C, 0);
+        return;
+    }
+
+    i2c_transaction_t * p_transaction = &m_queue[m_queue_head];
+    if (0 != p_transaction->tries)
+    {
+        // Back off before retrying, so a device that is missing doesn't keep the bus busy.
+        uint32_t delay_ms = I2C_RETRY_DELAY_MS << (p_transaction->tries - 1);
+        if (!clock_ms_have_passed(p_transaction->retry_ticks, delay_ms))
+        {
+            scheduler_set_period(SCHEDULER_MODULE_I2C, I2C_RETRY_DELAY_MS);
+            return;
+        }
+    }
+
+    scheduler_set_period(SCHEDULER_MODULE_I2C, 0);
+    i2c_start();
+}
+
+
+uint32_t i2c_write(uint8_t address, uint8_t const * p_data, uint32_t size, i2c_callback_t callback, void * p_context)
+{
+    if (I2C_MAX_DATA_SIZE < size)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    if (I2C_QUEUE_SIZE <= m_queue_count)
+    {
+        m_dropped_count++;
+        return NRF_ERROR_NO_MEM;
+    }
+
+    i2c_transaction_t * p_transaction = &m_queue[(m_queue_head + m_queue_count) % I2C_QUEUE_SIZE];
+    p_transaction->address = address;
+    p_transaction->size = size;
+    p_transaction->tries = 0;
+    p_transaction->callback = callback;
+    p_transaction->p_context = p_context;
+    memcpy(p_transaction->data, p_data, size);
+    m_queue_count++;
+
+    scheduler_set_pending(SCHEDULER_MODULE_I2C);
+    return NRF_SUCCESS;
 }
 
 
 void i2c_byte_write(uint8_t address, uint8_t data)
 {
-    int i = NUM_TRIES;
-    uint32_t result;
-    do
-    {
-        result = nrf_drv_twi_tx(&m_twi_master, address, &data, sizeof(data), false);
-        i--;
-    } while ((NRF_SUCCESS != result) && (0 < i));
+    (void)i2c_write(address, &data, sizeof(data), NULL, NULL);
 }
 
 
 void i2c_data_write(uint8_t address, uint8_t * p_data, uint32_t size)
 {
-    int i = NUM_TRIES;
-    uint32_t result;
-    do
+    (void)i2c_write(address, p_data, size, NULL, NULL);
+}
+
+
+i2c_device_stats_t const * i2c_get_device_stats(uint8_t address)
+{
+    for (int i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        if ((address == m_device_stats[i].address) && (0 != m_device_stats[i].errors))
+        {
+            return &m_device_stats[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+uint32_t i2c_get_dropped_count(void)
+{
+    return m_dropped_count;
+}
+
+
+static void i2c_start(void)
+{
+    i2c_transaction_t * p_transaction = &m_queue[m_queue_head];
+    p_transaction->tries++;
+
+    m_is_busy = true;
+    uint32_t result = nrf_drv_twi_tx(&m_twi_master, p_transaction->address, p_transaction->data, p_transaction->size, false);
+    if (NRF_SUCCESS != result)
     {
-        result = nrf_drv_twi_tx(&m_twi_master, address, p_data, size, false);
-        i--;
-    } while ((NRF_SUCCESS != result) && (0 < i));
+        // The driver didn't take it, handle it like a failed transfer.
+        m_is_success = false;
+        m_is_done = true;
+        scheduler_set_pending(SCHEDULER_MODULE_I2C);
+    }
+}
+
+
+static void i2c_finish(bool success)
+{
+    // Take it off the queue before the callback, so the callback can queue another write.
+    i2c_transaction_t transaction = m_queue[m_queue_head];
+    m_queue_head = (m_queue_head + 1) % I2C_QUEUE_SIZE;
+    m_queue_count--;
+
+    if (NULL != transaction.callback)
+    {
+        transaction.callback(transaction.address, success, transaction.p_context);
+    }
+}
+
+
+static i2c_device_stats_t * i2c_device_stats(uint8_t address)
+{
+    i2c_device_stats_t * p_free = NULL;
+    for (int i = 0; i < I2C_MAX_DEVICES; i++)
+    {
+        i2c_device_stats_t * p_stats = &m_device_stats[i];
+        if ((address == p_stats->address) && (0 != p_stats->errors))
+        {
+            return p_stats;
+        }
+
+        if ((NULL == p_free) && (0 == p_stats->errors))
+        {
+            p_free = p_stats;
+        }
+    }
+
+    if (NULL == p_free)
+    {
+        // Out of room, lump the rest in with the last address.
+        return &m_device_stats[I2C_MAX_DEVICES - 1];
+    }
+
+    p_free->address = address;
+    return p_free;
 }
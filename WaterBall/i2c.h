@@ -1,10 +1,15 @@
 /*
  * @brief i2c module.
+ *
+ * Writes are queued and sent in the background by the TWI driver, so a missing or
+ * NACKing device doesn't stall the main loop. A failed write is retried a few times
+ * with a growing delay before it is given up on.
  */
  
 #ifndef I2C_H
 #define I2C_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "app_error.h"
 
@@ -13,12 +18,57 @@
 
 #define MASTER_TWI_INST             0                               //!< MASTERTWI interface 
 
+#define I2C_QUEUE_SIZE              16                              //!< Number of writes that can be waiting to be sent.
+#define I2C_MAX_DATA_SIZE           11                              //!< Largest write, a whole HT16K33 frame plus its start address.
+#define I2C_MAX_TRIES               4                               //!< Number of times a write is tried before giving up.
+#define I2C_RETRY_DELAY_MS          5                               //!< Delay before the first retry, doubled on every retry after that.
+#define I2C_MAX_DEVICES             4                               //!< Number of addresses that error counters are kept for.
+
+// Called when a write has been sent, or given up on.
+typedef void (* i2c_callback_t)(uint8_t address, bool success, void * p_context);
+
+typedef struct
+{
+    uint8_t         address;
+    uint8_t         size;
+    uint8_t         tries;
+    uint8_t         data[I2C_MAX_DATA_SIZE];
+    uint32_t        retry_ticks;                                    //!< When the last try failed.
+    i2c_callback_t  callback;
+    void *          p_context;
+} i2c_transaction_t;
+
+typedef struct
+{
+    uint8_t         address;
+    uint32_t        errors;                                         //!< Number of tries that failed.
+    uint32_t        failures;                                       //!< Number of writes that were given up on.
+} i2c_device_stats_t;
+
 void i2c_init(void);
 
 void i2c_tasks(void);
 
+// Queue a write, the data is copied so it doesn't need to outlive the call.
+uint32_t i2c_write(uint8_t address, uint8_t const * p_data, uint32_t size, i2c_callback_t callback, void * p_context);
+
 void i2c_byte_write(uint8_t address, uint8_t data);
 
 void i2c_data_write(uint8_t address, uint8_t * p_data, uint32_t size);
 
+// Get the error counters of an address, or NULL if it has never had an error.
+i2c_device_stats_t const * i2c_get_device_stats(uint8_t address);
+
+// Get the number of writes that didn't fit in the queue.
+uint32_t i2c_get_dropped_count(void);
+
+// Start sending the write at the head of the queue.
+static void i2c_start(void);
+
+// Finish the write at the head of the queue and report it to its callback.
+static void i2c_finish(bool success);
+
+// Find the error counters of an address, adding them if it is new.
+static i2c_device_stats_t * i2c_device_stats(uint8_t address);
+
 #endif // I2C_H
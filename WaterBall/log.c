@@ -0,0 +1,109 @@
+/**
+ * @file
+ * @defgroup WaterBall log.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall deferred logging module.
+ */
+
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "clock.h"
+#include "log.h"
+#include "ring.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "telemetry.h"
+
+RING_DEF(m_queue, sizeof(log_entry_t), LOG_QUEUE_SIZE);
+
+static uint32_t                 m_lost_count;
+
+
+void log_init(void)
+{
+    ring_clear(&m_queue);
+    m_lost_count = 0;
+}
+
+
+void log_tasks(void)
+{
+    if (ring_is_empty(&m_queue) ||
+        (TELEMETRY_MODE_BINARY != telemetry_get_mode()))
+    {
+        scheduler_set_period(SCHEDULER_MODULE_LOG, 0);
+        return;
+    }
+
+    if (SERIAL_TX_BUF_SIZE != serial_get_tx_room())
+    {
+        // Something else is being sent, the log can wait until it is done.
+        scheduler_set_period(SCHEDULER_MODULE_LOG, LOG_DRAIN_PERIOD_MS);
+        return;
+    }
+
+    for (int i = 0; (i < LOG_DRAIN_COUNT) && !ring_is_empty(&m_queue); i++)
+    {
+        // The writer drops the oldest entry when the queue is full, so it consumes too.
+        log_entry_t entry;
+        CRITICAL_REGION_ENTER();
+        (void)ring_read(&m_queue, &entry, 1);
+        CRITICAL_REGION_EXIT();
+
+        log_send(&entry);
+    }
+
+    scheduler_set_period(SCHEDULER_MODULE_LOG, ring_is_empty(&m_queue) ? 0 : LOG_DRAIN_PERIOD_MS);
+}
+
+
+void log_write(log_id_t id, uint32_t argc, uint32_t arg0, uint32_t arg1, uint32_t arg2)
+{
+    log_entry_t entry;
+    entry.id = id;
+    entry.argc = argc;
+    entry.ticks = clock_get_ticks();
+    entry.args[0] = arg0;
+    entry.args[1] = arg1;
+    entry.args[2] = arg2;
+
+    // Any context can log, so there is more than one producer.
+    CRITICAL_REGION_ENTER();
+    if (ring_is_full(&m_queue))
+    {
+        // Full, so drop the oldest entry to make room.
+        ring_consume(&m_queue, 1);
+        m_lost_count++;
+    }
+
+    (void)ring_write(&m_queue, &entry, 1);
+    CRITICAL_REGION_EXIT();
+
+    scheduler_set_pending(SCHEDULER_MODULE_LOG);
+}
+
+
+uint32_t log_get_lost_count(void)
+{
+    return m_lost_count;
+}
+
+
+static void log_send(log_entry_t const * p_entry)
+{
+    static uint8_t record[TELEMETRY_MAX_RECORD_SIZE + TELEMETRY_CRC_SIZE];
+
+    uint8_t * p_record = record;
+    *p_record++ = TELEMETRY_RECORD_LOG;
+    *p_record++ = p_entry->id;
+    p_record += uint32_encode(p_entry->ticks, p_record);
+    for (int i = 0; i < p_entry->argc; i++)
+    {
+        p_record += uint32_encode(p_entry->args[i], p_record);
+    }
+
+    telemetry_send_record(record, p_record - record);
+}
+
+/** @} */
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @defgroup WaterBall log.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall deferred logging module.
+ *
+ * A log call only stores the message ID, the time and up to LOG_MAX_ARGS integer
+ * arguments in a RAM ring, so it is cheap enough to leave in production code. The
+ * ring is sent over the serial port as telemetry records while the binary telemetry
+ * mode is on, and only when the serial transmit ring is idle. If it fills up the oldest
+ * entries are overwritten, so the most recent history is always there.
+ *
+ * The messages are listed in log_ids.h.
+ */
+
+#ifndef LOG_H__
+#define LOG_H__
+
+#include <stdint.h>
+
+#include "log_ids.h"
+
+#ifndef LOG_ENABLED
+#define LOG_ENABLED                     (1)
+#endif
+
+#define LOG_QUEUE_SIZE                  (16)        /**< Must be a power of two. */
+#define LOG_MAX_ARGS                    (3)
+#define LOG_DRAIN_PERIOD_MS             (20)        /**< How often to check if the serial port has gone idle. */
+#define LOG_DRAIN_COUNT                 (4)         /**< The most entries sent each time the log module runs. */
+
+#if LOG_ENABLED
+#define LOG0(ID)                        log_write(ID, 0, 0, 0, 0)
+#define LOG1(ID, A)                     log_write(ID, 1, (uint32_t)(A), 0, 0)
+#define LOG2(ID, A, B)                  log_write(ID, 2, (uint32_t)(A), (uint32_t)(B), 0)
+#define LOG3(ID, A, B, C)               log_write(ID, 3, (uint32_t)(A), (uint32_t)(B), (uint32_t)(C))
+#else
+#define LOG0(ID)
+#define LOG1(ID, A)
+#define LOG2(ID, A, B)
+#define LOG3(ID, A, B, C)
+#endif
+
+#define LOG_ID_ENUM(ID, FORMAT)         ID,
+
+/**
+ * @brief   The message IDs, in the order of log_ids.h.
+ */
+typedef enum
+{
+    LOG_MESSAGES(LOG_ID_ENUM)
+    LOG_ID_COUNT
+} log_id_t;
+
+/**
+ * @brief   A logged message waiting to be sent.
+ */
+typedef struct
+{
+    uint8_t     id;
+    uint8_t     argc;
+    uint32_t    ticks;
+    uint32_t    args[LOG_MAX_ARGS];
+} log_entry_t;
+
+/**
+ * @brief   Function to initialize the log module.
+ */
+void log_init(void);
+
+/**
+ * @brief   Function to accomplish the log module tasks.
+ *
+ * @details This sends the logged messages while the serial port is idle.
+ */
+void log_tasks(void);
+
+/**
+ * @brief   Log a message, use the LOGn macros rather than calling this directly.
+ *
+ * @param[in]   id              The message to log.
+ * @param[in]   argc            The number of arguments that are used.
+ * @param[in]   arg0            The first argument.
+ * @param[in]   arg1            The second argument.
+ * @param[in]   arg2            The third argument.
+ */
+void log_write(log_id_t id, uint32_t argc, uint32_t arg0, uint32_t arg1, uint32_t arg2);
+
+/**
+ * @brief   Get the number of messages that were overwritten before they were sent.
+ *
+ * @retval      The number of lost messages.
+ */
+uint32_t log_get_lost_count(void);
+
+/**
+ * @brief   Send a logged message as a telemetry record.
+ *
+ * @param[in]   p_entry         The message to send.
+ */
+static void log_send(log_entry_t const * p_entry);
+
+#endif //LOG_H__
+
+/** @} */
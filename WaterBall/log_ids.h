@@ -0,0 +1,41 @@
+/**
+ * @file
+ * @defgroup WaterBall log_ids.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall log message table.
+ *
+ * Every message that can be logged, in the form X(ID, "format"). The device only sends
+ * the position of the message in this table and its integer arguments, the format is
+ * never compiled into the firmware. Tools/Telemetry/log_decode.py reads this file to put
+ * the messages back together, so keep each entry on a line of its own and only add new
+ * entries at the end, or old captures will decode to the wrong messages.
+ *
+ * The formats can use %u, %d and %x, with at most LOG_MAX_ARGS arguments.
+ */
+
+#ifndef LOG_IDS_H__
+#define LOG_IDS_H__
+
+#define LOG_MESSAGES(X)                                                                         \
+    X(LOG_GAME_STATE,                   "game state %u -> %u")                                  \
+    X(LOG_GAME_BUTTON,                  "game button %u in state %u")                           \
+    X(LOG_GAME_OVER,                    "game over my score %u their score %u")                 \
+    X(LOG_CLIENT_CONNECTED,             "client connected handle %u")                           \
+    X(LOG_CLIENT_DISCONNECTED,          "client disconnected reason 0x%x")                      \
+    X(LOG_CLIENT_SERVICE_NOT_FOUND,     "client service not found")                             \
+    X(LOG_CLIENT_SETTINGS,              "client settings game time %u vibration %u target score %u") \
+    X(LOG_CLIENT_TIMEOUT,               "client gatt timeout source %u")                        \
+    X(LOG_STORAGE_RESTORED_SWAP,        "storage restored from swap")                           \
+    X(LOG_STORAGE_CLEARED,              "storage checksum bad, cleared")                        \
+    X(LOG_STORAGE_UPDATE,               "storage update address %u size %u")                    \
+    X(LOG_STORAGE_LOCKED,               "storage locked, address %u not updated")               \
+    X(LOG_STORAGE_ERROR,                "storage op %u failed 0x%x")                            \
+    X(LOG_GAME_REACTION,                "game presses %u first %u us fastest %u us")               \
+    X(LOG_SYNC_ROUND,                   "sync offset %d ticks round trip %d ticks drift %d ppb")   \
+    X(LOG_GAME_START,                   "game start %u us after the agreed time")                \
+    X(LOG_GAME_BUTTON_DROPPED,          "game button %u dropped, the queue is full")
+
+#endif //LOG_IDS_H__
+
+/** @} */
@@ -1,78 +1,94 @@
-/**
- * @file
- * @defgroup WaterBall main.c
- * @{
- * @ingroup WaterBall
- * @brief WaterBall application main file.
- *
- * It is intended that this file will have a main function that initializes all
- * of the supporting modules, and then an infinite loop that calls of the supporting
- * modules allowing them to perform work.
- */
- 
-#include "advertise.h"
-#include "ble_stack.h"
-#include "bsp.h"
-#include "buttons.h"
-#include "clock.h"
-#include "connect.h"
-#include "dev_man.h"
-#include "dfu.h"
-#include "discovery.h"
-#include "game.h"
-#include "i2c.h"
-#include "ir_led.h"
-#include "serial.h"
-#include "service.h"
-#include "seven_segment.h"
-#include "status.h"
-#include "storage.h"
-#include "watchdog.h"
-
-/**
- * @brief Function for main application entry.
- */
-int main(void)
-{
-    ble_stack_init();
-    watchdog_init();
-    dev_man_init();                 /**< Run before storage_init, since it also uses pstorage and will initialize it. */
-    storage_init();
-    status_init();
-    buttons_init();
-    clock_init();
-    serial_init();
-    service_init();
-    dfu_init();                     /**< Initialize after the service, or else it won't work. */
-    advertise_init();
-    discovery_init();
-    connect_init();
-    i2c_init();
-    seven_segment_init();
-    ir_led_init();
-    game_init();
-
-
-    while (true)
-    {
-        ble_stack_tasks();
-        watchdog_tasks();
-        dev_man_tasks();
-        storage_tasks();
-        status_tasks();
-        buttons_tasks();
-        clock_tasks();
-        serial_tasks();
-        service_tasks();
-        dfu_tasks();
-        advertise_tasks();
-        discovery_tasks();
-        connect_tasks();
-        i2c_tasks();
-        seven_segment_tasks();
-        ir_led_tasks();
-        game_tasks();
-    }
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall main.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall application main file.
+ *
+ * It is intended that this file will have a main function that initializes all
+ * of the supporting modules, registers their tasks with the scheduler, and then an
+ * infinite loop that lets the scheduler run the modules that have work to do.
+ */
+ 
+#include "advertise.h"
+#include "ble_stack.h"
+#include "bsp.h"
+#include "buttons.h"
+#include "clock.h"
+#include "connect.h"
+#include "dev_man.h"
+#include "dfu.h"
+#include "discovery.h"
+#include "game.h"
+#include "i2c.h"
+#include "ir_led.h"
+#include "log.h"
+#include "profile.h"
+#include "serial.h"
+#include "scheduler.h"
+#include "service.h"
+#include "seven_segment.h"
+#include "shell.h"
+#include "status.h"
+#include "storage.h"
+#include "sync.h"
+#include "timers.h"
+#include "watchdog.h"
+
+/**
+ * @brief Function for main application entry.
+ */
+int main(void)
+{
+    scheduler_init();               /**< Run first, since interrupts from the other modules mark work as pending. */
+    log_init();                     /**< Run before the modules that log while they initialize. */
+    ble_stack_init();
+    watchdog_init();
+    dev_man_init();                 /**< Run before storage_init, since it also uses pstorage and will initialize it. */
+    storage_init();
+    status_init();
+    clock_init();
+    timers_init();                  /**< Run after clock_init, the wheel turns on the 64 bit clock. */
+    buttons_init();                 /**< Run after clock_init, the score button is timestamped on its high resolution time. */
+    serial_init();
+    service_init();
+    sync_init();
+    dfu_init();                     /**< Initialize after the service, or else it won't work. */
+    advertise_init();
+    discovery_init();
+    connect_init();
+    i2c_init();
+    seven_segment_init();
+    ir_led_init();
+    game_init();
+    profile_init();
+    shell_init();
+
+    scheduler_register(SCHEDULER_MODULE_BLE_STACK,     ble_stack_tasks,      SCHEDULER_PRIORITY_HIGH,    0, 0);
+    scheduler_register(SCHEDULER_MODULE_WATCHDOG,      watchdog_tasks,       SCHEDULER_PRIORITY_HIGH,    WATCHDOG_FEED_PERIOD_MS, 0);
+    scheduler_register(SCHEDULER_MODULE_DEV_MAN,       dev_man_tasks,        SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_STORAGE,       storage_tasks,        SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_STATUS,        status_tasks,         SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_BUTTONS,       buttons_tasks,        SCHEDULER_PRIORITY_HIGH,    0, 0);
+    scheduler_register(SCHEDULER_MODULE_CLOCK,         clock_tasks,          SCHEDULER_PRIORITY_MEDIUM,  CLOCK_EXTEND_PERIOD_MS, 0);
+    scheduler_register(SCHEDULER_MODULE_TIMERS,        timers_tasks,         SCHEDULER_PRIORITY_HIGH,    0, 0);
+    scheduler_register(SCHEDULER_MODULE_SERIAL,        serial_tasks,         SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_SERVICE,       service_tasks,        SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_DFU,           dfu_tasks,            SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_ADVERTISE,     advertise_tasks,      SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_DISCOVERY,     discovery_tasks,      SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_CONNECT,       connect_tasks,        SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_I2C,           i2c_tasks,            SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_SEVEN_SEGMENT, seven_segment_tasks,  SCHEDULER_PRIORITY_MEDIUM,  0, 0);
+    scheduler_register(SCHEDULER_MODULE_IR_LED,        ir_led_tasks,         SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_GAME,          game_tasks,           SCHEDULER_PRIORITY_HIGH,    0, GAME_DEADLINE_MS);
+    scheduler_register(SCHEDULER_MODULE_SHELL,         shell_tasks,          SCHEDULER_PRIORITY_LOW,     0, 0);
+    scheduler_register(SCHEDULER_MODULE_LOG,           log_tasks,            SCHEDULER_PRIORITY_LOW,     0, 0);
+
+    while (true)
+    {
+        scheduler_tasks();
+    }
+}
+
+/** @} */
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * @defgroup WaterBall profile.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall main loop profiler module.
+ */
+
+#include <string.h>
+
+#include "app_error.h"
+#include "clock.h"
+#include "nordic_common.h"
+#include "profile.h"
+#include "service.h"
+#include "shell.h"
+
+static profile_stats_t          m_stats[SCHEDULER_MODULE_COUNT];
+static uint64_t                 m_start_us;
+
+
+void profile_init(void)
+{
+    profile_clear();
+}
+
+
+void profile_start(void)
+{
+    // The high resolution time is only requested while a module is being timed, so that it
+    // doesn't keep the high frequency clock running while we sleep.
+    clock_hf_request();
+    m_start_us = clock_hf_get_us64();
+}
+
+
+void profile_stop(scheduler_module_t module)
+{
+    uint32_t us = (uint32_t)(clock_hf_get_us64() - m_start_us);
+    clock_hf_release();
+
+    profile_stats_t * p_stats = &m_stats[module];
+    p_stats->count++;
+    p_stats->total_us += us;
+    p_stats->min_us = MIN(p_stats->min_us, us);
+    p_stats->max_us = MAX(p_stats->max_us, us);
+    p_stats->histogram[profile_histogram_bucket(us)]++;
+}
+
+
+profile_stats_t const * profile_get_stats(scheduler_module_t module)
+{
+    return &m_stats[module];
+}
+
+
+void profile_get_record(scheduler_module_t module, profile_record_t * p_record)
+{
+    profile_stats_t * p_stats = &m_stats[module];
+    p_record->count  = p_stats->count;
+    p_record->min_us = (0 == p_stats->count) ? 0 : p_stats->min_us;
+    p_record->avg_us = (0 == p_stats->count) ? 0 : (uint32_t)(p_stats->total_us / p_stats->count);
+    p_record->max_us = p_stats->max_us;
+}
+
+
+void profile_get_records(profile_record_t * p_records)
+{
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        profile_get_record((scheduler_module_t)module, &p_records[module]);
+    }
+}
+
+
+bool profile_print_line(uint32_t line)
+{
+    if (0 == line)
+    {
+        shell_printf("\r\nmodule          count     min     avg     max  histogram (<4us, x4 per bucket)\r\n");
+        return true;
+    }
+
+    uint32_t module = line - 1;
+    if (module < SCHEDULER_MODULE_COUNT)
+    {
+        profile_record_t record;
+        profile_get_record((scheduler_module_t)module, &record);
+        uint32_t * p_histogram = m_stats[module].histogram;
+        shell_printf("%-14s %6u %7u %7u %7u  %u %u %u %u %u %u %u %u\r\n",
+                     scheduler_get_module_name((scheduler_module_t)module),
+                     record.count, record.min_us, record.avg_us, record.max_us,
+                     p_histogram[0], p_histogram[1], p_histogram[2], p_histogram[3],
+                     p_histogram[4], p_histogram[5], p_histogram[6], p_histogram[7]);
+        return true;
+    }
+
+    service_latency_t const * p_latency = service_get_score_latency();
+    if (SCHEDULER_MODULE_COUNT == module)
+    {
+        uint32_t const * p_histogram = p_latency->histogram;
+        shell_printf("score latency  %6u %7u %7u %7u  %u %u %u %u %u %u %u %u (ms, <8ms x2 per bucket)\r\n",
+                     p_latency->count,
+                     (0 == p_latency->count) ? 0 : CLOCK_TICKS_IN_MS(p_latency->min_ticks),
+                     (0 == p_latency->count) ? 0 : CLOCK_TICKS_IN_MS(p_latency->total_ticks / p_latency->count),
+                     CLOCK_TICKS_IN_MS(p_latency->max_ticks),
+                     p_histogram[0], p_histogram[1], p_histogram[2], p_histogram[3],
+                     p_histogram[4], p_histogram[5], p_histogram[6], p_histogram[7]);
+        return true;
+    }
+
+    shell_printf("score lost %u superseded %u\r\n", p_latency->lost, p_latency->superseded);
+    return false;
+}
+
+
+void profile_clear(void)
+{
+    memset(m_stats, 0, sizeof(m_stats));
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        m_stats[module].min_us = UINT32_MAX;
+    }
+}
+
+
+static uint32_t profile_histogram_bucket(uint32_t us)
+{
+    uint32_t bucket = 0;
+    for (us >>= 2; (0 != us) && (bucket < (PROFILE_HISTOGRAM_BUCKETS - 1)); us >>= 2)
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+/** @} */
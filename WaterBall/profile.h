@@ -0,0 +1,119 @@
+/**
+ * @file
+ * @defgroup WaterBall profile.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall main loop profiler module.
+ *
+ * Every tasks function run by the scheduler is timed with the high resolution time of
+ * the clock module. It is only requested while a tasks function is running, so it doesn't
+ * keep the high frequency clock on while the CPU sleeps.
+ *
+ * For each module a call count, the minimum, average and maximum durations, and a
+ * histogram of durations are kept. The "perf" shell command dumps them, and
+ * they can be read over BLE from the profile characteristic of the game service.
+ */
+
+#ifndef PROFILE_H__
+#define PROFILE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "scheduler.h"
+
+#define PROFILE_HISTOGRAM_BUCKETS       (8)                         /**< Bucket n counts durations of [4^n, 4^(n+1)) us, the last bucket counts everything longer. */
+
+/**
+ * @brief   The timing statistics of a single module.
+ */
+typedef struct
+{
+    uint32_t    count;                                      /**< The number of times the module has been run. */
+    uint32_t    min_us;                                     /**< The shortest run of the module. */
+    uint32_t    max_us;                                     /**< The longest run of the module. */
+    uint64_t    total_us;                                   /**< The time spent in the module, used to calculate the average. */
+    uint32_t    histogram[PROFILE_HISTOGRAM_BUCKETS];       /**< The number of runs in each duration bucket. */
+} profile_stats_t;
+
+/**
+ * @brief   The statistics of a single module as they are sent over BLE.
+ */
+typedef struct
+{
+    uint32_t    count;
+    uint32_t    min_us;
+    uint32_t    avg_us;
+    uint32_t    max_us;
+} profile_record_t;
+
+/**
+ * @brief   Function to initialize the profile module.
+ */
+void profile_init(void);
+
+/**
+ * @brief   Start timing a tasks function.
+ */
+void profile_start(void);
+
+/**
+ * @brief   Stop timing a tasks function and add the duration to the statistics of the module.
+ *
+ * @param[in]   module          The module whose tasks function was timed.
+ */
+void profile_stop(scheduler_module_t module);
+
+/**
+ * @brief   Get the statistics of a module.
+ *
+ * @param[in]   module          The module to get the statistics of.
+ *
+ * @retval      A pointer to the statistics of the module.
+ */
+profile_stats_t const * profile_get_stats(scheduler_module_t module);
+
+/**
+ * @brief   Fill in the statistics of a module in the format used over BLE.
+ *
+ * @param[in]   module          The module to get the statistics of.
+ * @param[out]  p_record        The record to fill in.
+ */
+void profile_get_record(scheduler_module_t module, profile_record_t * p_record);
+
+/**
+ * @brief   Fill in the statistics of every module in the format used over BLE.
+ *
+ * @param[out]  p_records       The array to fill in, it must have room for SCHEDULER_MODULE_COUNT records.
+ */
+void profile_get_records(profile_record_t * p_records);
+
+/**
+ * @brief   Write one line of the statistics to the serial port.
+ *
+ * @details The first line is the heading, then there is a line for every module, followed
+ *          by the score latency.
+ *
+ * @param[in]   line            The line to write, starting at 0.
+ *
+ * @retval      True if there are more lines to write.
+ */
+bool profile_print_line(uint32_t line);
+
+/**
+ * @brief   Clear the statistics of every module.
+ */
+void profile_clear(void);
+
+/**
+ * @brief   Find the histogram bucket that a duration belongs in.
+ *
+ * @param[in]   us              The duration.
+ *
+ * @retval      The index of the histogram bucket.
+ */
+static uint32_t profile_histogram_bucket(uint32_t us);
+
+#endif //PROFILE_H__
+
+/** @} */
@@ -0,0 +1,151 @@
+/**
+ * @file
+ * @defgroup WaterBall ring.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall single producer, single consumer ring buffer module.
+ */
+
+#include <string.h>
+
+#include "nordic_common.h"
+#include "nrf.h"
+#include "ring.h"
+
+
+void ring_clear(ring_t * p_ring)
+{
+    p_ring->read_count = p_ring->write_count;
+}
+
+
+uint32_t ring_count(ring_t const * p_ring)
+{
+    // The counters wrap together, so the difference is right even after they roll over.
+    return p_ring->write_count - p_ring->read_count;
+}
+
+
+uint32_t ring_room(ring_t const * p_ring)
+{
+    return ring_capacity(p_ring) - ring_count(p_ring);
+}
+
+
+uint32_t ring_capacity(ring_t const * p_ring)
+{
+    return p_ring->mask + 1;
+}
+
+
+bool ring_is_empty(ring_t const * p_ring)
+{
+    return p_ring->write_count == p_ring->read_count;
+}
+
+
+bool ring_is_full(ring_t const * p_ring)
+{
+    return ring_count(p_ring) == ring_capacity(p_ring);
+}
+
+
+uint32_t ring_get_high_water(ring_t const * p_ring)
+{
+    return p_ring->high_water;
+}
+
+
+uint32_t ring_write(ring_t * p_ring, void const * p_data, uint32_t count)
+{
+    ring_span_t spans[RING_SPAN_COUNT];
+    count = MIN(count, ring_write_spans(p_ring, spans));
+    ring_copy(p_ring, spans, (uint8_t *)p_data, count, true);
+    ring_publish(p_ring, count);
+    return count;
+}
+
+
+uint32_t ring_write_spans(ring_t * p_ring, ring_span_t * p_spans)
+{
+    uint32_t room = ring_room(p_ring);
+    ring_spans(p_ring, p_ring->write_count, room, p_spans);
+    return room;
+}
+
+
+void ring_publish(ring_t * p_ring, uint32_t count)
+{
+    if (0 == count)
+    {
+        return;
+    }
+
+    // The elements must be in the buffer before the consumer can see them.
+    __DMB();
+    p_ring->write_count += count;
+
+    p_ring->high_water = MAX(p_ring->high_water, ring_count(p_ring));
+}
+
+
+uint32_t ring_peek(ring_t const * p_ring, ring_span_t * p_spans)
+{
+    uint32_t count = ring_count(p_ring);
+    ring_spans(p_ring, p_ring->read_count, count, p_spans);
+    return count;
+}
+
+
+void ring_consume(ring_t * p_ring, uint32_t count)
+{
+    count = MIN(count, ring_count(p_ring));
+
+    // The elements must be read before the producer can write over them.
+    __DMB();
+    p_ring->read_count += count;
+}
+
+
+uint32_t ring_read(ring_t * p_ring, void * p_data, uint32_t count)
+{
+    ring_span_t spans[RING_SPAN_COUNT];
+    count = MIN(count, ring_peek(p_ring, spans));
+    ring_copy(p_ring, spans, (uint8_t *)p_data, count, false);
+    ring_consume(p_ring, count);
+    return count;
+}
+
+
+static void ring_spans(ring_t const * p_ring, uint32_t counter, uint32_t count, ring_span_t * p_spans)
+{
+    uint32_t index = counter & p_ring->mask;
+
+    // First section - before rollover, then the second section - after rollover, if any.
+    p_spans[0].p_data = &p_ring->p_buffer[index * p_ring->element_size];
+    p_spans[0].size   = MIN(count, ring_capacity(p_ring) - index);
+    p_spans[1].p_data = p_ring->p_buffer;
+    p_spans[1].size   = count - p_spans[0].size;
+}
+
+
+static void ring_copy(ring_t const * p_ring, ring_span_t const * p_spans, uint8_t * p_data, uint32_t count, bool to_ring)
+{
+    for (int i = 0; (i < RING_SPAN_COUNT) && (0 < count); i++)
+    {
+        uint32_t size = MIN(count, p_spans[i].size) * p_ring->element_size;
+        if (to_ring)
+        {
+            memcpy(p_spans[i].p_data, p_data, size);
+        }
+        else
+        {
+            memcpy(p_data, p_spans[i].p_data, size);
+        }
+
+        p_data += size;
+        count -= MIN(count, p_spans[i].size);
+    }
+}
+
+/** @} */
@@ -0,0 +1,214 @@
+/**
+ * @file
+ * @defgroup WaterBall ring.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall single producer, single consumer ring buffer module.
+ *
+ * A ring of fixed size elements, for queuing between one producer and one consumer that
+ * may be in different interrupt contexts. The number of elements is a power of two, and
+ * the read and write counters run freely and are masked to index the buffer, so every
+ * element can be used and no division is needed.
+ *
+ * Only the producer changes the write counter and only the consumer changes the read
+ * counter, so neither side needs a critical region. A side with more than one caller, or
+ * a producer that throws away the oldest elements to make room, must make its own
+ * critical region.
+ *
+ * Besides copying elements in and out, both sides can work on the ring in place: the
+ * producer fills the free spans and then publishes them, and the consumer peeks at the
+ * filled spans and then consumes them.
+ */
+
+#ifndef RING_H__
+#define RING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_util.h"
+
+#define RING_SPAN_COUNT                 (2)         /**< A run of elements is at most split in two by the rollover. */
+
+/**
+ * @brief   Define a ring and the buffer behind it.
+ *
+ * @details The buffer is word aligned, so elements whose size is a multiple of four bytes can
+ *          be used in place as structures.
+ *
+ * @param[in]   NAME            The name of the ring_t variable.
+ * @param[in]   ELEMENT_SIZE    The size of an element in bytes.
+ * @param[in]   COUNT           The number of elements, a power of two.
+ */
+#define RING_DEF(NAME, ELEMENT_SIZE, COUNT)                                             \
+        STATIC_ASSERT(IS_POWER_OF_TWO(COUNT));                                          \
+        static uint32_t NAME##_buffer[CEIL_DIV((ELEMENT_SIZE) * (COUNT), sizeof(uint32_t))]; \
+        static ring_t NAME = { (uint8_t *)NAME##_buffer, (ELEMENT_SIZE), (COUNT) - 1, 0, 0, 0 }
+
+/**
+ * @brief   A run of elements that are next to each other in the buffer.
+ */
+typedef struct
+{
+    uint8_t *           p_data;
+    uint32_t            size;                   /**< The number of elements. */
+} ring_span_t;
+
+/**
+ * @brief   A ring, define it with RING_DEF.
+ */
+typedef struct
+{
+    uint8_t *           p_buffer;
+    uint32_t            element_size;
+    uint32_t            mask;                   /**< The number of elements minus one. */
+    volatile uint32_t   write_count;            /**< Elements ever published, only changed by the producer. */
+    volatile uint32_t   read_count;             /**< Elements ever consumed, only changed by the consumer. */
+    uint32_t            high_water;             /**< The most elements that have been in the ring at once. */
+} ring_t;
+
+/**
+ * @brief   Throw away everything in the ring, this is a consumer function.
+ *
+ * @param[in]   p_ring          The ring.
+ */
+void ring_clear(ring_t * p_ring);
+
+/**
+ * @brief   Get the number of elements in the ring.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      The number of elements waiting to be consumed.
+ */
+uint32_t ring_count(ring_t const * p_ring);
+
+/**
+ * @brief   Get the number of free elements in the ring.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      The number of elements that can be published.
+ */
+uint32_t ring_room(ring_t const * p_ring);
+
+/**
+ * @brief   Get the number of elements the ring holds.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      The number of elements.
+ */
+uint32_t ring_capacity(ring_t const * p_ring);
+
+/**
+ * @brief   Check if the ring is empty.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      True if there is nothing to consume.
+ */
+bool ring_is_empty(ring_t const * p_ring);
+
+/**
+ * @brief   Check if the ring is full.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      True if there is no room to publish.
+ */
+bool ring_is_full(ring_t const * p_ring);
+
+/**
+ * @brief   Get the most elements that have been in the ring at once.
+ *
+ * @param[in]   p_ring          The ring.
+ *
+ * @retval      The high water mark.
+ */
+uint32_t ring_get_high_water(ring_t const * p_ring);
+
+/**
+ * @brief   Copy elements into the ring and publish them, this is a producer function.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[in]   p_data          The elements to copy.
+ * @param[in]   count           The number of elements to copy.
+ *
+ * @retval      The number of elements that fit.
+ */
+uint32_t ring_write(ring_t * p_ring, void const * p_data, uint32_t count);
+
+/**
+ * @brief   Get the free elements, to fill in place, this is a producer function.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[out]  p_spans         A pointer to RING_SPAN_COUNT spans to fill in.
+ *
+ * @retval      The total number of elements in the spans.
+ */
+uint32_t ring_write_spans(ring_t * p_ring, ring_span_t * p_spans);
+
+/**
+ * @brief   Make elements that were filled in place available to the consumer, this is a producer function.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[in]   count           The number of elements that were filled, from the start of the free spans.
+ */
+void ring_publish(ring_t * p_ring, uint32_t count);
+
+/**
+ * @brief   Look at the elements in the ring in place, this is a consumer function.
+ *
+ * @details The spans stay valid until the elements are consumed.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[out]  p_spans         A pointer to RING_SPAN_COUNT spans to fill in.
+ *
+ * @retval      The total number of elements in the spans.
+ */
+uint32_t ring_peek(ring_t const * p_ring, ring_span_t * p_spans);
+
+/**
+ * @brief   Remove elements from the front of the ring, this is a consumer function.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[in]   count           The number of elements to remove, it is cut to the number in the ring.
+ */
+void ring_consume(ring_t * p_ring, uint32_t count);
+
+/**
+ * @brief   Copy elements out of the ring and consume them, this is a consumer function.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[out]  p_data          Where to copy the elements to.
+ * @param[in]   count           The most elements to copy.
+ *
+ * @retval      The number of elements copied.
+ */
+uint32_t ring_read(ring_t * p_ring, void * p_data, uint32_t count);
+
+/**
+ * @brief   Split a run of elements starting at a counter into the parts before and after the rollover.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[in]   counter         The read or write counter where the run starts.
+ * @param[in]   count           The number of elements in the run.
+ * @param[out]  p_spans         A pointer to RING_SPAN_COUNT spans to fill in.
+ */
+static void ring_spans(ring_t const * p_ring, uint32_t counter, uint32_t count, ring_span_t * p_spans);
+
+/**
+ * @brief   Copy between a buffer and the spans of a run of elements.
+ *
+ * @param[in]   p_ring          The ring.
+ * @param[in]   p_spans         The spans of the run.
+ * @param[in]   p_data          The buffer.
+ * @param[in]   count           The number of elements to copy.
+ * @param[in]   to_ring         True to copy from the buffer into the spans, false for the other way.
+ */
+static void ring_copy(ring_t const * p_ring, ring_span_t const * p_spans, uint8_t * p_data, uint32_t count, bool to_ring);
+
+#endif //RING_H__
+
+/** @} */
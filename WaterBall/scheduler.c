@@ -0,0 +1,365 @@
+/**
+ * @file
+ * @defgroup WaterBall scheduler.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall main loop scheduler module.
+ */
+
+#include <string.h>
+
+#include "app_error.h"
+#include "app_timer.h"
+#include "app_util_platform.h"
+#include "clock.h"
+#include "nrf_soc.h"
+#include "profile.h"
+#include "scheduler.h"
+
+APP_TIMER_DEF(m_wakeup_timer_id);
+
+static scheduler_task_t     m_tasks[SCHEDULER_MODULE_COUNT];
+static volatile uint32_t    m_pending;
+static uint32_t             m_wakeup_count;
+static uint64_t             m_sleep_ticks;
+static uint32_t             m_max_wakeup_late_ticks;
+static uint64_t             m_wakeup_target_ticks;      // The release the app_timer was last armed for, on the 64 bit clock.
+static volatile bool        m_is_wakeup_armed;          // Cleared by the app_timer when it fires.
+static char const * const   m_module_names[SCHEDULER_MODULE_COUNT] =
+{
+    "ble_stack",
+    "watchdog",
+    "dev_man",
+    "storage",
+    "status",
+    "buttons",
+    "clock",
+    "timers",
+    "serial",
+    "service",
+    "dfu",
+    "advertise",
+    "discovery",
+    "connect",
+    "i2c",
+    "seven_segment",
+    "ir_led",
+    "game",
+    "shell",
+    "log"
+};
+
+
+static void scheduler_wakeup_handler(void * p_context)
+{
+    // Waking up is enough for the due tasks to be released, the timer only has to be armed again.
+    m_is_wakeup_armed = false;
+}
+
+
+void scheduler_init(void)
+{
+    memset(m_tasks, 0, sizeof(m_tasks));
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        m_tasks[module].wakeup_ticks = SCHEDULER_NO_WAKEUP;
+    }
+
+    m_pending = 0;
+    m_wakeup_count = 0;
+    m_sleep_ticks = 0;
+    m_max_wakeup_late_ticks = 0;
+    m_wakeup_target_ticks = SCHEDULER_NO_WAKEUP;
+    m_is_wakeup_armed = false;
+}
+
+
+void scheduler_register(scheduler_module_t   module,
+                        scheduler_tasks_t    tasks,
+                        scheduler_priority_t priority,
+                        uint32_t             period_ms,
+                        uint32_t             deadline_ms)
+{
+    APP_ERROR_CHECK_BOOL(SCHEDULER_MODULE_COUNT > module);
+
+    // The timer can't be created in scheduler_init since that runs before the timer module is initialized.
+    static bool wakeup_timer_created = false;
+    if (!wakeup_timer_created)
+    {
+        APP_ERROR_CHECK(app_timer_create(&m_wakeup_timer_id, APP_TIMER_MODE_SINGLE_SHOT, scheduler_wakeup_handler));
+        wakeup_timer_created = true;
+    }
+
+    scheduler_task_t * p_task = &m_tasks[module];
+    p_task->tasks           = tasks;
+    p_task->priority        = priority;
+    p_task->period_ticks    = CLOCK_MS_IN_TICKS(period_ms);
+    p_task->deadline_ticks  = CLOCK_MS_IN_TICKS(deadline_ms);
+    p_task->release_ticks   = clock_get_ticks();
+    scheduler_set_pending(module);
+}
+
+
+void scheduler_tasks(void)
+{
+    scheduler_release_due_tasks();
+
+    int module = scheduler_take_most_urgent();
+    if (0 > module)
+    {
+        scheduler_sleep();
+        return;
+    }
+
+    scheduler_task_t * p_task = &m_tasks[module];
+    uint32_t deadline_ticks = scheduler_deadline_ticks(p_task);
+    if ((0 != deadline_ticks) &&
+        clock_ticks_have_passed(p_task->release_ticks, deadline_ticks))
+    {
+        p_task->missed_count++;
+    }
+
+    p_task->run_count++;
+    profile_start();
+    p_task->tasks();
+    profile_stop((scheduler_module_t)module);
+}
+
+
+void scheduler_set_pending(scheduler_module_t module)
+{
+    CRITICAL_REGION_ENTER();
+    uint32_t mask = SCHEDULER_MODULE_MASK(module);
+    if (0 == (m_pending & mask))
+    {
+        // The deadline is measured from the moment the work became pending.
+        m_tasks[module].release_ticks = clock_get_ticks();
+        m_pending |= mask;
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+
+void scheduler_set_period(scheduler_module_t module, uint32_t period_ms)
+{
+    scheduler_task_t * p_task = &m_tasks[module];
+    uint32_t period_ticks = CLOCK_MS_IN_TICKS(period_ms);
+    if (period_ticks == p_task->period_ticks)
+    {
+        return;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (0 == (m_pending & SCHEDULER_MODULE_MASK(module)))
+    {
+        // Start counting the new period from now.
+        p_task->release_ticks = clock_get_ticks();
+    }
+
+    p_task->period_ticks = period_ticks;
+    CRITICAL_REGION_EXIT();
+}
+
+
+void scheduler_set_wakeup(scheduler_module_t module, uint64_t ticks)
+{
+    // The wakeup is only ever read from the main loop, so it doesn't need a critical region.
+    m_tasks[module].wakeup_ticks = ticks;
+}
+
+
+void scheduler_set_all_pending(void)
+{
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        scheduler_set_pending((scheduler_module_t)module);
+    }
+}
+
+
+uint32_t scheduler_get_run_count(scheduler_module_t module)
+{
+    return m_tasks[module].run_count;
+}
+
+
+uint32_t scheduler_get_missed_count(scheduler_module_t module)
+{
+    return m_tasks[module].missed_count;
+}
+
+
+char const * scheduler_get_module_name(scheduler_module_t module)
+{
+    return m_module_names[module];
+}
+
+
+uint32_t scheduler_get_wakeup_count(void)
+{
+    return m_wakeup_count;
+}
+
+
+uint64_t scheduler_get_sleep_ticks(void)
+{
+    return m_sleep_ticks;
+}
+
+
+uint32_t scheduler_get_max_wakeup_late_ticks(void)
+{
+    return m_max_wakeup_late_ticks;
+}
+
+
+uint32_t scheduler_estimate_ua(void)
+{
+    uint64_t total_ticks = clock_get_ticks64();
+    if (0 == total_ticks)
+    {
+        return 0;
+    }
+
+    // Charge in uA ticks, the wakeups are converted from nC with the 32768 ticks per second.
+    uint64_t sleep_ticks = MIN(m_sleep_ticks, total_ticks);
+    uint64_t charge = ((total_ticks - sleep_ticks) * SCHEDULER_RUN_UA) +
+                      (sleep_ticks * SCHEDULER_SLEEP_UA) +
+                      ((uint64_t)m_wakeup_count * SCHEDULER_WAKEUP_NC * APP_TIMER_CLOCK_FREQ / 1000);
+    return (uint32_t)(charge / total_ticks);
+}
+
+
+static uint32_t scheduler_deadline_ticks(scheduler_task_t * p_task)
+{
+    return (0 != p_task->deadline_ticks) ? p_task->deadline_ticks : p_task->period_ticks;
+}
+
+
+static void scheduler_release_due_tasks(void)
+{
+    uint64_t now_ticks = clock_get_ticks64();
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        scheduler_task_t * p_task = &m_tasks[module];
+        if (p_task->wakeup_ticks <= now_ticks)
+        {
+            m_max_wakeup_late_ticks = MAX(m_max_wakeup_late_ticks, (uint32_t)(now_ticks - p_task->wakeup_ticks));
+            p_task->wakeup_ticks = SCHEDULER_NO_WAKEUP;
+            scheduler_set_pending((scheduler_module_t)module);
+        }
+
+        if ((0 == p_task->period_ticks) ||
+            (0 != (m_pending & SCHEDULER_MODULE_MASK(module))))
+        {
+            continue;
+        }
+
+        uint32_t passed = clock_ticks_since(p_task->release_ticks);
+        if (passed < p_task->period_ticks)
+        {
+            continue;
+        }
+
+        CRITICAL_REGION_ENTER();
+        // Release on the period boundary so that the period doesn't drift, unless we fell
+        // more than a whole period behind.
+        p_task->release_ticks = (passed < (2 * p_task->period_ticks)) ?
+                                p_task->release_ticks + p_task->period_ticks :
+                                clock_get_ticks();
+        m_pending |= SCHEDULER_MODULE_MASK(module);
+        CRITICAL_REGION_EXIT();
+    }
+}
+
+
+static int scheduler_take_most_urgent(void)
+{
+    int     most_urgent = -1;
+    int32_t most_urgent_slack = INT32_MAX;
+
+    CRITICAL_REGION_ENTER();
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        scheduler_task_t * p_task = &m_tasks[module];
+        if ((0 == (m_pending & SCHEDULER_MODULE_MASK(module))) ||
+            (NULL == p_task->tasks))
+        {
+            continue;
+        }
+
+        // Tasks without a deadline have all the slack in the world, so they are only ordered by priority.
+        int32_t slack = INT32_MAX;
+        uint32_t deadline_ticks = scheduler_deadline_ticks(p_task);
+        if (0 != deadline_ticks)
+        {
+            slack = (int32_t)deadline_ticks - (int32_t)clock_ticks_since(p_task->release_ticks);
+        }
+
+        if ((0 > most_urgent) ||
+            (p_task->priority < m_tasks[most_urgent].priority) ||
+            ((p_task->priority == m_tasks[most_urgent].priority) && (slack < most_urgent_slack)))
+        {
+            most_urgent = module;
+            most_urgent_slack = slack;
+        }
+    }
+
+    if (0 <= most_urgent)
+    {
+        m_pending &= ~SCHEDULER_MODULE_MASK(most_urgent);
+    }
+    CRITICAL_REGION_EXIT();
+
+    return most_urgent;
+}
+
+
+static uint64_t scheduler_next_release_ticks(uint64_t now_ticks)
+{
+    uint64_t next_release_ticks = SCHEDULER_NO_WAKEUP;
+    for (int module = 0; module < SCHEDULER_MODULE_COUNT; module++)
+    {
+        scheduler_task_t * p_task = &m_tasks[module];
+        next_release_ticks = MIN(next_release_ticks, p_task->wakeup_ticks);
+
+        if (0 != p_task->period_ticks)
+        {
+            // Place the last release on the 64 bit clock, so the result doesn't move with the time now.
+            uint64_t release_ticks = now_ticks - (((uint32_t)now_ticks - p_task->release_ticks) & CLOCK_TICKS_MASK);
+            next_release_ticks = MIN(next_release_ticks, release_ticks + p_task->period_ticks);
+        }
+    }
+
+    return next_release_ticks;
+}
+
+
+static void scheduler_sleep(void)
+{
+    // A single RTC compare for whatever comes first, there is no tick to wake us up otherwise.
+    // Starting and stopping the app_timer pends its interrupt, which ends the next sleep right
+    // away, so it is only armed again when the release it is waiting for has changed.
+    uint64_t now_ticks = clock_get_ticks64();
+    uint64_t target_ticks = scheduler_next_release_ticks(now_ticks);
+    if (!m_is_wakeup_armed || (target_ticks != m_wakeup_target_ticks))
+    {
+        uint64_t timeout_ticks = (target_ticks <= now_ticks) ? 0 : target_ticks - now_ticks;
+        APP_ERROR_CHECK(app_timer_stop(m_wakeup_timer_id));
+        m_wakeup_target_ticks = target_ticks;
+        m_is_wakeup_armed = true;
+        APP_ERROR_CHECK(app_timer_start(m_wakeup_timer_id,
+                                        (uint32_t)MAX(MIN(timeout_ticks, SCHEDULER_MAX_SLEEP_TICKS),
+                                                      APP_TIMER_MIN_TIMEOUT_TICKS),
+                                        NULL));
+    }
+
+    // Any interrupt that fires after the pending bitmap was checked will set the event
+    // register, so this returns right away instead of missing the new work.
+    uint64_t sleep_start_ticks = clock_get_ticks64();
+    APP_ERROR_CHECK(sd_app_evt_wait());
+    m_sleep_ticks += clock_get_ticks64() - sleep_start_ticks;
+    m_wakeup_count++;
+}
+
+/** @} */
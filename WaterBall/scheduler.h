@@ -0,0 +1,268 @@
+/**
+ * @file
+ * @defgroup WaterBall scheduler.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall main loop scheduler module.
+ *
+ * Each module that has a tasks function registers it with the scheduler. Instead of
+ * calling every tasks function on every pass of the main loop, the scheduler keeps a
+ * bitmap of the modules that have pending work. Interrupts, BLE events and timers mark
+ * a module as pending, and only those modules are run. When no module has pending work
+ * the CPU sleeps until the next event.
+ *
+ * A module that needs to keep polling (blinking an LED, counting down) marks itself
+ * pending again from inside its own tasks function, or registers with a period. A module
+ * can also ask to be made pending at a time on the 64 bit clock, the timers module uses
+ * this for the earliest expiry on its wheel.
+ *
+ * Only one tasks function is run per call to scheduler_tasks, and it is always the most
+ * urgent one that is pending: the highest priority, and within a priority the one closest
+ * to (or furthest past) its deadline. A deadline is measured from the moment the work
+ * became pending, and every time a module starts after its deadline it is counted as
+ * missed.
+ *
+ * The idle loop is tickless: before sleeping the scheduler finds the earliest periodic
+ * release or wakeup time of all the modules and arms a single app_timer, which is an RTC
+ * compare, for it. Nothing else wakes the CPU but real events. The time spent asleep and
+ * the number of wakeups are counted, and give an estimate of the average current.
+ */
+
+#ifndef SCHEDULER_H__
+#define SCHEDULER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SCHEDULER_MODULE_MASK(MODULE)       (1UL << (MODULE))
+#define SCHEDULER_ALL_MODULES               (SCHEDULER_MODULE_MASK(SCHEDULER_MODULE_COUNT) - 1)
+#define SCHEDULER_NO_WAKEUP                 (UINT64_MAX)
+#define SCHEDULER_MAX_SLEEP_TICKS           (CLOCK_TICKS_MASK / 2)      /**< The longest the app_timer is armed for, well inside the range of the RTC. */
+
+#define SCHEDULER_SLEEP_UA                  (3)         /**< System on with the RTC and the SoftDevice idle, from the nRF51 datasheet. */
+#define SCHEDULER_RUN_UA                    (4400)      /**< The CPU running from flash at 16 MHz. */
+#define SCHEDULER_WAKEUP_NC                 (20)        /**< Starting the 16 MHz clock and the regulator on each wakeup, in nC. */
+
+/**
+ * @brief   The modules that can be run by the scheduler.
+ */
+typedef enum
+{
+    SCHEDULER_MODULE_BLE_STACK = 0,
+    SCHEDULER_MODULE_WATCHDOG,
+    SCHEDULER_MODULE_DEV_MAN,
+    SCHEDULER_MODULE_STORAGE,
+    SCHEDULER_MODULE_STATUS,
+    SCHEDULER_MODULE_BUTTONS,
+    SCHEDULER_MODULE_CLOCK,
+    SCHEDULER_MODULE_TIMERS,
+    SCHEDULER_MODULE_SERIAL,
+    SCHEDULER_MODULE_SERVICE,
+    SCHEDULER_MODULE_DFU,
+    SCHEDULER_MODULE_ADVERTISE,
+    SCHEDULER_MODULE_DISCOVERY,
+    SCHEDULER_MODULE_CONNECT,
+    SCHEDULER_MODULE_I2C,
+    SCHEDULER_MODULE_SEVEN_SEGMENT,
+    SCHEDULER_MODULE_IR_LED,
+    SCHEDULER_MODULE_GAME,
+    SCHEDULER_MODULE_SHELL,
+    SCHEDULER_MODULE_LOG,
+    SCHEDULER_MODULE_COUNT
+} scheduler_module_t;
+
+/**
+ * @brief   The priority of a module, the lower the value the more urgent.
+ */
+typedef enum
+{
+    SCHEDULER_PRIORITY_HIGH = 0,        /**< Time critical work, like the game display and scoring. */
+    SCHEDULER_PRIORITY_MEDIUM,          /**< Work that should be done soon, like the connection state machines. */
+    SCHEDULER_PRIORITY_LOW              /**< Work that can wait, like flash and uart. */
+} scheduler_priority_t;
+
+/**
+ * @brief   A module tasks function.
+ */
+typedef void (* scheduler_tasks_t)(void);
+
+/**
+ * @brief   The scheduling information of a single module.
+ */
+typedef struct
+{
+    scheduler_tasks_t       tasks;              /**< The tasks function of the module. */
+    scheduler_priority_t    priority;           /**< The priority of the module. */
+    uint32_t                period_ticks;       /**< How often the module is made pending, 0 if it isn't periodic. */
+    uint32_t                deadline_ticks;     /**< How long the module can be pending before it must run, 0 to use the period. */
+    uint32_t                release_ticks;      /**< When the module last became pending. */
+    uint64_t                wakeup_ticks;       /**< When the module is next made pending on the 64 bit clock, or SCHEDULER_NO_WAKEUP. */
+    uint32_t                run_count;          /**< The number of times the module has run. */
+    uint32_t                missed_count;       /**< The number of times the module has started after its deadline. */
+} scheduler_task_t;
+
+/**
+ * @brief   Function to initialize the scheduler module.
+ */
+void scheduler_init(void);
+
+/**
+ * @brief   Register the tasks function of a module.
+ *
+ * @details Registered modules start out pending so that they all run at least once.
+ *
+ * @param[in]   module          The module that the tasks function belongs to.
+ * @param[in]   tasks           The tasks function of the module.
+ * @param[in]   priority        The priority of the module.
+ * @param[in]   period_ms       How often the module should be made pending, or 0 if only events make it pending.
+ * @param[in]   deadline_ms     How long the module can be pending before it must run, or 0 to use the period.
+ */
+void scheduler_register(scheduler_module_t   module,
+                        scheduler_tasks_t    tasks,
+                        scheduler_priority_t priority,
+                        uint32_t             period_ms,
+                        uint32_t             deadline_ms);
+
+/**
+ * @brief   Run the most urgent module that has pending work, or sleep if there is nothing to do.
+ *
+ * @details This should be called repeatedly from the main loop.
+ */
+void scheduler_tasks(void);
+
+/**
+ * @brief   Mark a module as having pending work.
+ *
+ * @details This is safe to call from interrupt context.
+ *
+ * @param[in]   module          The module that has work to do.
+ */
+void scheduler_set_pending(scheduler_module_t module);
+
+/**
+ * @brief   Change how often a module is made pending.
+ *
+ * @details A module that only needs to poll while it is in some states can turn its period
+ *          on and off, rather than marking itself pending on every run and starving the
+ *          lower priority modules.
+ *
+ * @param[in]   module          The module to change the period of.
+ * @param[in]   period_ms       How often the module should be made pending, or 0 to stop.
+ */
+void scheduler_set_period(scheduler_module_t module, uint32_t period_ms);
+
+/**
+ * @brief   Make a module pending at a time on the 64 bit clock.
+ *
+ * @details Only one wakeup is kept per module, so this replaces the last one. The CPU
+ *          sleeps until the earliest wakeup of every module.
+ *
+ * @param[in]   module          The module to wake up.
+ * @param[in]   ticks           When to make it pending, from clock_get_ticks64, or SCHEDULER_NO_WAKEUP.
+ */
+void scheduler_set_wakeup(scheduler_module_t module, uint64_t ticks);
+
+/**
+ * @brief   Mark every module as having pending work.
+ *
+ * @details This is safe to call from interrupt context.
+ */
+void scheduler_set_all_pending(void);
+
+/**
+ * @brief   Get the number of times the tasks function of a module has been run.
+ *
+ * @param[in]   module          The module to get the count of.
+ *
+ * @retval      The number of times the module has been run.
+ */
+uint32_t scheduler_get_run_count(scheduler_module_t module);
+
+/**
+ * @brief   Get the number of times a module has started after its deadline.
+ *
+ * @param[in]   module          The module to get the count of.
+ *
+ * @retval      The number of missed deadlines of the module.
+ */
+uint32_t scheduler_get_missed_count(scheduler_module_t module);
+
+/**
+ * @brief   Get the name of a module, for printing.
+ *
+ * @param[in]   module          The module to get the name of.
+ *
+ * @retval      The name of the module.
+ */
+char const * scheduler_get_module_name(scheduler_module_t module);
+
+/**
+ * @brief   Get the number of times the CPU has woken up from sleep.
+ *
+ * @retval      The number of times the scheduler has slept.
+ */
+uint32_t scheduler_get_wakeup_count(void);
+
+/**
+ * @brief   Get the number of ticks the CPU has spent asleep.
+ *
+ * @retval      The time asleep on the 64 bit clock.
+ */
+uint64_t scheduler_get_sleep_ticks(void);
+
+/**
+ * @brief   Get the latest that a module has been made pending after its wakeup time.
+ *
+ * @retval      The largest wakeup error in ticks.
+ */
+uint32_t scheduler_get_max_wakeup_late_ticks(void);
+
+/**
+ * @brief   Estimate the average current since start up.
+ *
+ * @details The time awake and asleep are weighted with typical currents, and every wakeup
+ *          adds the charge it takes to start the 16 MHz clock. It doesn't know about the
+ *          radio, the leds or the displays, so it is only good for comparing the idle loop.
+ *
+ * @retval      The estimated average current in uA.
+ */
+uint32_t scheduler_estimate_ua(void);
+
+/**
+ * @brief   Get the deadline of a module, which is the period if no deadline was given.
+ *
+ * @param[in]   p_task          The module to get the deadline of.
+ *
+ * @retval      The deadline in ticks, or 0 if the module has no deadline.
+ */
+static uint32_t scheduler_deadline_ticks(scheduler_task_t * p_task);
+
+/**
+ * @brief   Make every module whose period has passed or whose wakeup time has come pending.
+ */
+static void scheduler_release_due_tasks(void);
+
+/**
+ * @brief   Atomically find the most urgent pending module and clear its pending bit.
+ *
+ * @retval      The most urgent module, or -1 if no module is pending.
+ */
+static int scheduler_take_most_urgent(void);
+
+/**
+ * @brief   Find the next periodic release or wakeup of any module.
+ *
+ * @param[in]   now_ticks       The time now on the 64 bit clock.
+ *
+ * @retval      The time of the next release on the 64 bit clock, or SCHEDULER_NO_WAKEUP.
+ */
+static uint64_t scheduler_next_release_ticks(uint64_t now_ticks);
+
+/**
+ * @brief   Sleep until the next application event or the next release.
+ */
+static void scheduler_sleep(void);
+
+#endif //SCHEDULER_H__
+
+/** @} */
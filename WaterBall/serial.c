@@ -1,278 +1,624 @@
-/**
- * @file
- * @defgroup WaterBall serial.c
- * @{
- * @ingroup WaterBall
- * @brief WaterBall serial communication module.
- */
-
-#include <string.h>
-#include "app_error.h"
-#include "app_uart.h"
-#include "bsp.h"
-#include "serial.h"
-
-static serial_state_t           m_serial_state;
-static uint8_t                  m_serial_rx_buffer[SERIAL_RX_BUF_SIZE];
-static uint32_t                 m_serial_rx_buffer_write_i;
-static uint32_t                 m_serial_rx_buffer_read_i;
-static uint32_t                 m_err_code;
-
-/**
- * @brief Function for handling events raised by the uart driver.
- *
- * @param[in]  p_event      A pointer to the event occured.
- */
-static void serial_evt_handler(app_uart_evt_t * p_event)
-{
-    switch (p_event->evt_type)
-    {
-        case APP_UART_TX_EMPTY:
-        {
-            break;
-        }
-        case APP_UART_COMMUNICATION_ERROR:
-        {
-            m_err_code = p_event->data.error_communication;
-            break;
-        }
-        case APP_UART_FIFO_ERROR:
-        {
-            m_err_code = p_event->data.error_code;
-            if (NRF_ERROR_NO_MEM != m_err_code)
-            {
-                m_serial_state = SERIAL_STATE_ERROR;
-            }
-
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-void serial_init(void)
-{
-    m_serial_state = SERIAL_STATE_INIT;
-    m_serial_rx_buffer_write_i = 0;
-    m_serial_rx_buffer_read_i = 0;
-}
-
-
-void serial_tasks()
-{
-    switch (m_serial_state)
-    {
-        case SERIAL_STATE_INIT:
-        {
-            m_serial_state = SERIAL_STATE_CLOSED;
-            break;
-        }
-        case SERIAL_STATE_CLOSED:
-        {
-            break;
-        }
-        case SERIAL_STATE_OPENED:
-        {
-            // Read from the uart in the main loop, so that we will continue to try even after the buffer is full.
-            // If this is put in the interrupt handler and the buffer fills we won't be able to receive any more
-            // uart data because RTS will be high preventing the peer from sending any data so we won't get any
-            // more uart interrupts.
-            serial_fifo_to_rx_buffer();
-            break;
-        }
-        case SERIAL_STATE_ERROR:
-        {
-            APP_ERROR_HANDLER(m_err_code);
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-bool serial_try_open(void)
-{
-    if (SERIAL_STATE_OPENED == m_serial_state)
-    {
-        // We are already open so just make sure RTS is correct.
-        m_serial_state = SERIAL_STATE_OPENED;
-        return true;
-    }
-
-    static uint8_t     rx_buf[UART_RX_BUF_SIZE];
-    static uint8_t     tx_buf[UART_TX_BUF_SIZE];
-    app_uart_buffers_t buffers;
-    const app_uart_comm_params_t comm_params =
-    {
-        RX_PIN_NUMBER,
-        TX_PIN_NUMBER,
-        RTS_PIN_NUMBER,
-        CTS_PIN_NUMBER,
-        APP_UART_FLOW_CONTROL_ENABLED,
-        false,
-        UART_BAUDRATE_BAUDRATE_Baud115200
-    };
-
-    buffers.rx_buf      = rx_buf;
-    buffers.rx_buf_size = sizeof (rx_buf);
-    buffers.tx_buf      = tx_buf;
-    buffers.tx_buf_size = sizeof (tx_buf);
-    APP_ERROR_CHECK(app_uart_init(&comm_params,
-                                  &buffers,
-                                  serial_evt_handler,
-                                  APP_IRQ_PRIORITY_LOW));
-
-
-    // We aren't using CTS so make sure it has a pulldown.
-    nrf_gpio_cfg_sense_input(CTS_PIN_NUMBER, NRF_GPIO_PIN_PULLDOWN, NRF_GPIO_PIN_SENSE_HIGH);
-    m_serial_state = SERIAL_STATE_OPENED;
-    return true;
-}
-
-
-bool serial_try_close(void)
-{
-    if (SERIAL_STATE_CLOSED != m_serial_state)
-    {
-        m_serial_state = SERIAL_STATE_CLOSED;
-    }
-
-    return true;
-}
-
-
-static uint32_t serial_copy_rx_buffer(uint8_t * p_buffer, uint32_t size)
-{
-    uint32_t serial_rx_buffer_write_i = m_serial_rx_buffer_write_i;
-    uint32_t serial_rx_buffer_read_i = m_serial_rx_buffer_read_i;
-
-    if (IS_BUFFER_EMPTY(serial_rx_buffer_read_i, serial_rx_buffer_write_i, m_serial_rx_buffer) ||
-        (0 == size))
-    {
-        return 0;
-    }
-
-    uint32_t return_size = BUFFER_FILLED_COUNT(serial_rx_buffer_read_i, serial_rx_buffer_write_i, m_serial_rx_buffer);
-
-    return_size = MIN(return_size, size);
-
-    // Copy first section of buffer - before rollover.
-    uint32_t read_size = MIN(return_size, sizeof(m_serial_rx_buffer) - serial_rx_buffer_read_i);
-    memcpy(p_buffer, &m_serial_rx_buffer[m_serial_rx_buffer_read_i], read_size);
-
-    // Copy second section of buffer - after rollover, if any.
-    p_buffer += read_size;
-    read_size = return_size - read_size;
-    memcpy(p_buffer, m_serial_rx_buffer, read_size);
-
-    return return_size;
-}
-
-
-uint32_t serial_try_read_line(uint8_t * p_buffer, uint32_t size)
-{
-    uint32_t return_size = 0;
-    uint32_t new_bytes;
-    char * carriage_return = NULL;
-
-    do
-    {
-        new_bytes = 0;
-        return_size = serial_copy_rx_buffer(p_buffer, size);
-
-        if (0 == return_size)
-        {
-            // There weren't any bytes at all, so just return.
-            return 0;
-        }
-
-        // There are some bytes to check for a newline.
-        return_size = 0;
-        carriage_return = strpbrk((char *)p_buffer, "\r\n");
-
-        if ((NULL == carriage_return) &&
-            IS_BUFFER_FULL(m_serial_rx_buffer_read_i, m_serial_rx_buffer_write_i, m_serial_rx_buffer))
-        {
-            // No carriage return or new line, but the buffer was full, so remove the oldest byte and scan again.
-            INCREMENT_BUFFER_INDEX(m_serial_rx_buffer_read_i, 1, m_serial_rx_buffer);
-            new_bytes = serial_fifo_to_rx_buffer();
-        }
-    } while (0 < new_bytes);
-
-    if (NULL != carriage_return)
-    {
-        // Add one to the size to make sure we return the newline;
-        return_size = (carriage_return - (char *)&p_buffer[0]) + 1;
-    }
-
-    memset(&p_buffer[return_size], 0, sizeof(m_serial_rx_buffer) - return_size);
-    if (0 < return_size)
-    {
-        INCREMENT_BUFFER_INDEX(m_serial_rx_buffer_read_i, return_size, m_serial_rx_buffer);
-    }
-
-    return return_size;
-}
-
-
-uint32_t serial_read_existing(uint8_t * p_buffer, uint32_t size)
-{
-    uint32_t return_size = serial_copy_rx_buffer(p_buffer, size);
-
-    if (0 < return_size)
-    {
-        INCREMENT_BUFFER_INDEX(m_serial_rx_buffer_read_i, return_size, m_serial_rx_buffer);
-    }
-
-    return return_size;
-}
-
-
-void serial_write(uint8_t * p_buffer, uint32_t size)
-{
-    if (0 == size)
-    {
-        return;
-    }
-
-    serial_try_open();
-
-    for (int i = 0; i < size; i++)
-    {
-        while(app_uart_put(p_buffer[i]) != NRF_SUCCESS);
-    }
-}
-
-
-static uint32_t serial_fifo_to_rx_buffer(void)
-{
-    uint32_t err_code;
-    uint32_t new_bytes = 0;
-
-    do
-    {
-        if (IS_BUFFER_FULL(m_serial_rx_buffer_read_i, m_serial_rx_buffer_write_i, m_serial_rx_buffer))
-        {
-            // Don't read any bytes if the buffer is full. This is the most effective way to keep RTS high.
-            break;
-        }
-
-        err_code = app_uart_get(&m_serial_rx_buffer[m_serial_rx_buffer_write_i]);
-        if (NRF_SUCCESS == err_code)
-        {
-            new_bytes++;
-            INCREMENT_BUFFER_INDEX(m_serial_rx_buffer_write_i, 1, m_serial_rx_buffer);
-        }
-    } while(NRF_SUCCESS == err_code);
-
-    return new_bytes;
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall serial.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall serial communication module.
+ */
+
+#include <string.h>
+#include "app_error.h"
+#include "app_uart.h"
+#include "app_util_platform.h"
+#include "bsp.h"
+#include "clock.h"
+#include "nordic_common.h"
+#include "scheduler.h"
+#include "serial.h"
+
+RING_DEF(m_serial_rx_ring, sizeof(uint8_t), SERIAL_RX_BUF_SIZE);
+RING_DEF(m_serial_tx_ring, sizeof(uint8_t), SERIAL_TX_BUF_SIZE);
+
+static serial_state_t           m_serial_state;
+static uint32_t                 m_serial_rx_scanned;                // Bytes at the front of the receive ring already searched for a line end.
+static uint32_t                 m_err_code;
+static serial_tx_policy_t       m_serial_tx_policy;
+static uint32_t                 m_serial_tx_dropped_count;
+static uint32_t                 m_serial_tx_overwritten_count;
+static volatile bool            m_is_uart_tx_idle;                  // The uart fifo is empty and the last byte has gone out.
+static bool                     m_is_tx_remote;                     // The transmit ring goes to a BLE peer.
+static uint32_t                 m_baud;
+static uint32_t                 m_requested_baud;                   // A rate to switch to once everything has been sent, or 0.
+static bool                     m_is_baud_confirmed;
+static uint32_t                 m_baud_change_ticks;
+static serial_error_counts_t    m_error_counts;
+static const serial_baud_t      m_bauds[] =
+{
+    { 115200,   UART_BAUDRATE_BAUDRATE_Baud115200   },
+    { 230400,   UART_BAUDRATE_BAUDRATE_Baud230400   },
+    { 460800,   UART_BAUDRATE_BAUDRATE_Baud460800   },
+    { 921600,   UART_BAUDRATE_BAUDRATE_Baud921600   },
+    { 1000000,  UART_BAUDRATE_BAUDRATE_Baud1M       }
+};
+
+STATIC_ASSERT(IS_POWER_OF_TWO(UART_RX_BUF_SIZE));
+STATIC_ASSERT(UART_RX_BUF_SIZE >= (SERIAL_MAX_LATENCY_MS * SERIAL_BYTES_PER_MS(SERIAL_MAX_BAUD)));
+
+/**
+ * @brief Function for handling events raised by the uart driver.
+ *
+ * @param[in]  p_event      A pointer to the event occured.
+ */
+static void serial_evt_handler(app_uart_evt_t * p_event)
+{
+    switch (p_event->evt_type)
+    {
+        case APP_UART_DATA_READY:
+        {
+            scheduler_set_pending(SCHEDULER_MODULE_SERIAL);
+            break;
+        }
+        case APP_UART_TX_EMPTY:
+        {
+            m_is_uart_tx_idle = true;
+            serial_tx_buffer_to_fifo();
+            break;
+        }
+        case APP_UART_COMMUNICATION_ERROR:
+        {
+            m_err_code = p_event->data.error_communication;
+            m_error_counts.overrun += (0 != (m_err_code & UART_ERRORSRC_OVERRUN_Msk));
+            m_error_counts.parity += (0 != (m_err_code & UART_ERRORSRC_PARITY_Msk));
+            m_error_counts.framing += (0 != (m_err_code & UART_ERRORSRC_FRAMING_Msk));
+            m_error_counts.break_condition += (0 != (m_err_code & UART_ERRORSRC_BREAK_Msk));
+            break;
+        }
+        case APP_UART_FIFO_ERROR:
+        {
+            m_err_code = p_event->data.error_code;
+            m_error_counts.rx_fifo_full += (NRF_ERROR_NO_MEM == m_err_code);
+            if (NRF_ERROR_NO_MEM != m_err_code)
+            {
+                m_serial_state = SERIAL_STATE_ERROR;
+                scheduler_set_pending(SCHEDULER_MODULE_SERIAL);
+            }
+
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+void serial_init(void)
+{
+    m_serial_state = SERIAL_STATE_INIT;
+    ring_clear(&m_serial_rx_ring);
+    ring_clear(&m_serial_tx_ring);
+    m_serial_rx_scanned = 0;
+    m_serial_tx_policy = SERIAL_TX_POLICY_DROP_NEWEST;
+    m_serial_tx_dropped_count = 0;
+    m_serial_tx_overwritten_count = 0;
+    m_is_uart_tx_idle = true;
+    m_is_tx_remote = false;
+    m_baud = SERIAL_DEFAULT_BAUD;
+    m_requested_baud = 0;
+    m_is_baud_confirmed = true;
+    memset(&m_error_counts, 0, sizeof(m_error_counts));
+}
+
+
+void serial_tasks()
+{
+    switch (m_serial_state)
+    {
+        case SERIAL_STATE_INIT:
+        {
+            m_serial_state = SERIAL_STATE_CLOSED;
+            break;
+        }
+        case SERIAL_STATE_CLOSED:
+        {
+            break;
+        }
+        case SERIAL_STATE_OPENED:
+        {
+            // Read from the uart in the main loop, so that we will continue to try even after the buffer is full.
+            // If this is put in the interrupt handler and the buffer fills we won't be able to receive any more
+            // uart data because RTS will be high preventing the peer from sending any data so we won't get any
+            // more uart interrupts.
+            if (0 < serial_fifo_to_rx_buffer())
+            {
+                // Let the shell know that there is something new to look at.
+                scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+            }
+
+            serial_baud_tasks();
+            break;
+        }
+        case SERIAL_STATE_ERROR:
+        {
+            APP_ERROR_HANDLER(m_err_code);
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+bool serial_try_open(void)
+{
+    if (SERIAL_STATE_OPENED == m_serial_state)
+    {
+        // We are already open so just make sure RTS is correct.
+        m_serial_state = SERIAL_STATE_OPENED;
+        return true;
+    }
+
+    static uint8_t     rx_buf[UART_RX_BUF_SIZE];
+    static uint8_t     tx_buf[UART_TX_BUF_SIZE];
+    app_uart_buffers_t buffers;
+    const app_uart_comm_params_t comm_params =
+    {
+        RX_PIN_NUMBER,
+        TX_PIN_NUMBER,
+        RTS_PIN_NUMBER,
+        CTS_PIN_NUMBER,
+        APP_UART_FLOW_CONTROL_ENABLED,
+        false,
+        serial_find_baud(m_baud)->config
+    };
+
+    buffers.rx_buf      = rx_buf;
+    buffers.rx_buf_size = sizeof (rx_buf);
+    buffers.tx_buf      = tx_buf;
+    buffers.tx_buf_size = sizeof (tx_buf);
+    APP_ERROR_CHECK(app_uart_init(&comm_params,
+                                  &buffers,
+                                  serial_evt_handler,
+                                  APP_IRQ_PRIORITY_LOW));
+
+
+    // We aren't using CTS so make sure it has a pulldown.
+    nrf_gpio_cfg_sense_input(CTS_PIN_NUMBER, NRF_GPIO_PIN_PULLDOWN, NRF_GPIO_PIN_SENSE_HIGH);
+    m_is_uart_tx_idle = true;
+    m_serial_state = SERIAL_STATE_OPENED;
+    return true;
+}
+
+
+bool serial_try_close(void)
+{
+    if (SERIAL_STATE_CLOSED != m_serial_state)
+    {
+        m_serial_state = SERIAL_STATE_CLOSED;
+    }
+
+    return true;
+}
+
+
+static uint32_t serial_copy_rx_buffer(uint8_t * p_buffer, uint32_t size)
+{
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    uint32_t return_size = MIN(serial_peek(spans), size);
+
+    // Copy first section of buffer - before rollover.
+    uint32_t read_size = MIN(return_size, spans[0].size);
+    memcpy(p_buffer, spans[0].p_data, read_size);
+
+    // Copy second section of buffer - after rollover, if any.
+    memcpy(&p_buffer[read_size], spans[1].p_data, return_size - read_size);
+
+    return return_size;
+}
+
+
+bool serial_request_baud(uint32_t baud)
+{
+    if (NULL == serial_find_baud(baud))
+    {
+        return false;
+    }
+
+    m_requested_baud = baud;
+    scheduler_set_pending(SCHEDULER_MODULE_SERIAL);
+    return true;
+}
+
+
+void serial_confirm_baud(void)
+{
+    m_is_baud_confirmed = true;
+}
+
+
+uint32_t serial_get_baud(void)
+{
+    return m_baud;
+}
+
+
+serial_error_counts_t const * serial_get_error_counts(void)
+{
+    return &m_error_counts;
+}
+
+
+uint32_t serial_peek(serial_span_t * p_spans)
+{
+    return ring_peek(&m_serial_rx_ring, p_spans);
+}
+
+
+void serial_consume(uint32_t size)
+{
+    serial_rx_buffer_consume(MIN(size, ring_count(&m_serial_rx_ring)));
+}
+
+
+uint32_t serial_receive(uint8_t const * p_data, uint32_t size)
+{
+    uint32_t count = ring_write(&m_serial_rx_ring, p_data, size);
+    if (0 < count)
+    {
+        scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+    }
+
+    return count;
+}
+
+
+uint32_t serial_get_rx_room(void)
+{
+    return ring_room(&m_serial_rx_ring);
+}
+
+
+void serial_set_tx_remote(bool is_remote)
+{
+    m_is_tx_remote = is_remote;
+    if (m_is_tx_remote)
+    {
+        scheduler_set_pending(SCHEDULER_MODULE_SERVICE);
+    }
+    else
+    {
+        // Whatever the peer didn't get goes out the uart instead.
+        serial_tx_buffer_to_fifo();
+    }
+}
+
+
+uint32_t serial_tx_peek(serial_span_t * p_spans)
+{
+    return ring_peek(&m_serial_tx_ring, p_spans);
+}
+
+
+void serial_tx_consume(uint32_t size)
+{
+    // The overwrite policy consumes from the writing side, so this can't be lock free.
+    CRITICAL_REGION_ENTER();
+    ring_consume(&m_serial_tx_ring, size);
+    CRITICAL_REGION_EXIT();
+}
+
+
+uint32_t serial_try_read_line(uint8_t * p_buffer, uint32_t size)
+{
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    uint32_t filled;
+    uint32_t line_size = 0;
+
+    do
+    {
+        filled = ring_peek(&m_serial_rx_ring, spans);
+
+        // Only look at the bytes that have arrived since the last call, first the section before
+        // rollover and then the section after rollover, if any.
+        while ((0 == line_size) && (m_serial_rx_scanned < filled))
+        {
+            bool is_first_span = (m_serial_rx_scanned < spans[0].size);
+            uint8_t * p_scan = is_first_span ? &spans[0].p_data[m_serial_rx_scanned] :
+                                               &spans[1].p_data[m_serial_rx_scanned - spans[0].size];
+            uint32_t scan_size = is_first_span ? (spans[0].size - m_serial_rx_scanned) :
+                                                 (filled - m_serial_rx_scanned);
+            uint8_t * p_line_end = serial_find_line_end(p_scan, scan_size);
+
+            if (NULL != p_line_end)
+            {
+                // Add one to the size to make sure we return the newline;
+                scan_size = (p_line_end - p_scan) + 1;
+                line_size = m_serial_rx_scanned + scan_size;
+            }
+
+            m_serial_rx_scanned += scan_size;
+        }
+
+        if ((0 == line_size) && ring_is_full(&m_serial_rx_ring))
+        {
+            // No carriage return or new line, but the buffer is full, so the line will never fit.
+            // Throw away what we have and keep looking in the bytes still waiting in the fifo.
+            serial_rx_buffer_consume(filled);
+            if (0 == serial_fifo_to_rx_buffer())
+            {
+                break;
+            }
+        }
+        else
+        {
+            break;
+        }
+    } while (true);
+
+    if (0 == line_size)
+    {
+        return 0;
+    }
+
+    uint32_t return_size = serial_copy_rx_buffer(p_buffer, MIN(line_size, size));
+    if (return_size < size)
+    {
+        p_buffer[return_size] = 0;
+    }
+
+    // A line that is too big for the supplied buffer is cut short, the rest of it is thrown away.
+    serial_rx_buffer_consume(line_size);
+    return return_size;
+}
+
+
+uint32_t serial_read_existing(uint8_t * p_buffer, uint32_t size)
+{
+    uint32_t return_size = serial_copy_rx_buffer(p_buffer, size);
+    serial_rx_buffer_consume(return_size);
+    return return_size;
+}
+
+
+void serial_write(uint8_t * p_buffer, uint32_t size)
+{
+    if (0 == size)
+    {
+        return;
+    }
+
+    serial_try_open();
+
+    uint32_t written = 0;
+    while (written < size)
+    {
+        uint32_t count = size - written;
+
+        if (SERIAL_TX_POLICY_OVERWRITE_OLDEST == m_serial_tx_policy)
+        {
+            // Throw away the oldest bytes that haven't made it to the uart yet. This is the
+            // consumer's side of the ring, so keep the uart interrupt out.
+            CRITICAL_REGION_ENTER();
+            uint32_t room = ring_room(&m_serial_tx_ring);
+            if (room < count)
+            {
+                uint32_t overwrite = MIN(count, ring_capacity(&m_serial_tx_ring)) - room;
+                ring_consume(&m_serial_tx_ring, overwrite);
+                m_serial_tx_overwritten_count += overwrite;
+            }
+            CRITICAL_REGION_EXIT();
+        }
+
+        written += ring_write(&m_serial_tx_ring, &p_buffer[written], count);
+        if (m_is_tx_remote)
+        {
+            scheduler_set_pending(SCHEDULER_MODULE_SERVICE);
+        }
+        else
+        {
+            serial_tx_buffer_to_fifo();
+        }
+
+        if ((written < size) &&
+            ((SERIAL_TX_POLICY_DROP_NEWEST == m_serial_tx_policy) || m_is_tx_remote))
+        {
+            m_serial_tx_dropped_count += size - written;
+            break;
+        }
+    }
+}
+
+
+serial_tx_policy_t serial_set_tx_policy(serial_tx_policy_t policy)
+{
+    serial_tx_policy_t previous_policy = m_serial_tx_policy;
+    m_serial_tx_policy = policy;
+    return previous_policy;
+}
+
+
+uint32_t serial_get_tx_room(void)
+{
+    return ring_room(&m_serial_tx_ring);
+}
+
+
+uint32_t serial_get_tx_dropped_count(void)
+{
+    return m_serial_tx_dropped_count;
+}
+
+
+uint32_t serial_get_tx_overwritten_count(void)
+{
+    return m_serial_tx_overwritten_count;
+}
+
+
+uint32_t serial_get_rx_high_water(void)
+{
+    return ring_get_high_water(&m_serial_rx_ring);
+}
+
+
+uint32_t serial_get_tx_high_water(void)
+{
+    return ring_get_high_water(&m_serial_tx_ring);
+}
+
+
+static uint32_t serial_fifo_to_rx_buffer(void)
+{
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    uint32_t room = ring_write_spans(&m_serial_rx_ring, spans);
+    uint32_t new_bytes = 0;
+
+    // Don't read any bytes if the buffer is full. This is the most effective way to keep RTS high.
+    while ((new_bytes < room) &&
+           (NRF_SUCCESS == app_uart_get(serial_span_at(spans, new_bytes))))
+    {
+        new_bytes++;
+    }
+
+    ring_publish(&m_serial_rx_ring, new_bytes);
+    return new_bytes;
+}
+
+
+static void serial_baud_tasks(void)
+{
+    if (0 != m_requested_baud)
+    {
+        if (!serial_is_tx_idle())
+        {
+            // The answer to the request has to go out at the old rate.
+            scheduler_set_period(SCHEDULER_MODULE_SERIAL, SERIAL_BAUD_POLL_MS);
+            return;
+        }
+
+        serial_switch_baud(m_requested_baud);
+        m_is_baud_confirmed = (SERIAL_DEFAULT_BAUD == m_requested_baud);
+        m_baud_change_ticks = clock_get_ticks();
+        m_requested_baud = 0;
+    }
+
+    if (!m_is_baud_confirmed)
+    {
+        if (!clock_ms_have_passed(m_baud_change_ticks, SERIAL_BAUD_CONFIRM_MS))
+        {
+            scheduler_set_period(SCHEDULER_MODULE_SERIAL, SERIAL_BAUD_POLL_MS);
+            return;
+        }
+
+        // The peer never got through at the new rate, so go back to where we both started.
+        serial_switch_baud(SERIAL_DEFAULT_BAUD);
+        m_is_baud_confirmed = true;
+        m_error_counts.baud_fallbacks++;
+    }
+
+    scheduler_set_period(SCHEDULER_MODULE_SERIAL, 0);
+}
+
+
+static serial_baud_t const * serial_find_baud(uint32_t baud)
+{
+    for (int i = 0; i < ARRAY_SIZE(m_bauds); i++)
+    {
+        if (baud == m_bauds[i].baud)
+        {
+            return &m_bauds[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static void serial_switch_baud(uint32_t baud)
+{
+    // Anything that was on its way in at the old rate is garbage at the new one.
+    (void)app_uart_close();
+    ring_clear(&m_serial_rx_ring);
+    m_serial_rx_scanned = 0;
+
+    m_baud = baud;
+    m_serial_state = SERIAL_STATE_CLOSED;
+    serial_try_open();
+}
+
+
+static bool serial_is_tx_idle(void)
+{
+    return m_is_uart_tx_idle && ring_is_empty(&m_serial_tx_ring);
+}
+
+
+static void serial_rx_buffer_consume(uint32_t size)
+{
+    ring_consume(&m_serial_rx_ring, size);
+    m_serial_rx_scanned = (m_serial_rx_scanned > size) ? m_serial_rx_scanned - size : 0;
+
+    // Bytes that didn't fit may still be in the uart fifo, and with RTS up the peer won't send anything that would
+    // make us pending again, so come back and move them across now there is room.
+    scheduler_set_pending(SCHEDULER_MODULE_SERIAL);
+
+    if (m_is_tx_remote)
+    {
+        // There is room for more, so the BLE peer can be given more credits.
+        scheduler_set_pending(SCHEDULER_MODULE_SERVICE);
+    }
+}
+
+
+static uint8_t * serial_span_at(serial_span_t const * p_spans, uint32_t offset)
+{
+    return (offset < p_spans[0].size) ? &p_spans[0].p_data[offset] : &p_spans[1].p_data[offset - p_spans[0].size];
+}
+
+
+static uint8_t * serial_find_line_end(uint8_t * p_data, uint32_t size)
+{
+    uint8_t * p_line_end = memchr(p_data, '\r', size);
+    if (NULL != p_line_end)
+    {
+        // Only need to look for a new line before the carriage return.
+        size = p_line_end - p_data;
+    }
+
+    uint8_t * p_new_line = memchr(p_data, '\n', size);
+    return (NULL != p_new_line) ? p_new_line : p_line_end;
+}
+
+
+static void serial_tx_buffer_to_fifo(void)
+{
+    if (m_is_tx_remote)
+    {
+        return;
+    }
+
+    // This is called from both the main loop and the uart interrupt, so only one may consume at a time.
+    CRITICAL_REGION_ENTER();
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    uint32_t filled = ring_peek(&m_serial_tx_ring, spans);
+    uint32_t sent = 0;
+    while (sent < filled)
+    {
+        if (NRF_SUCCESS != app_uart_put(*serial_span_at(spans, sent)))
+        {
+            // The uart fifo is full, the rest is moved over when it empties.
+            break;
+        }
+
+        m_is_uart_tx_idle = false;
+        sent++;
+    }
+
+    ring_consume(&m_serial_tx_ring, sent);
+    CRITICAL_REGION_EXIT();
+}
+
+/** @} */
@@ -1,127 +1,373 @@
-/**
- * @file
- * @defgroup WaterBall serial.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall serial communication module.
- *
- * The basic philosophy is that the serial_tasks will be called from the main loop
- * and see if there are any bytes available from the SDKs uart module. If there are
- * read them and put them into a receive buffer.
- *
- * The receive buffer is made available to be read from. When it is successfully read
- * from any reamining bytes are moved to the head of the buffer.
- */
-
-#ifndef SERIAL_H__
-#define SERIAL_H__
-
-#include <stdbool.h>
-#include <stdint.h>
-
-#define UART_TX_BUF_SIZE         256                  /**< UART TX buffer size. */
-#define UART_RX_BUF_SIZE         256                  /**< UART RX buffer size. */
-#define SERIAL_RX_BUF_SIZE       256
-#define SERIAL_FLOW_CONTROL_BUF  (SERIAL_RX_BUF_SIZE - sizeof("\r"))
-
-#define SERIAL_TX_EMPTY_TIMEOUT  (CLOCK_MS_IN_TICKS(2))
-
-/**
- * @brief Increment the index into the buffer by the given count, rollover when we reach the max size.
- */
-#define INCREMENT_BUFFER_INDEX(INDEX, COUNT, BUFFER)                    \
-        (INDEX = (INDEX + COUNT) % sizeof(BUFFER))
-
-/**
- * @brief Determine the number of bytes that contain data in a buffer.
- */
-#define BUFFER_FILLED_COUNT(READ_I, WRITE_I, BUFFER)                    \
-        ((WRITE_I + sizeof(BUFFER) - READ_I) % sizeof(BUFFER))
-
-/**
- * @brief True if the buffer is full.
- */
-#define IS_BUFFER_FULL(READ_I, WRITE_I, BUFFER)                         \
-        (BUFFER_FILLED_COUNT(READ_I, WRITE_I, BUFFER) == (sizeof(BUFFER) - 1))
-
-/**
- * @brief True if the buffer is empty.
- */
-#define IS_BUFFER_EMPTY(READ_I, WRITE_I, BUFFER)                        \
-        (READ_I == WRITE_I)
-
-/**
- * @brief serial module states.
- */
-typedef enum
-{
-    SERIAL_STATE_INIT,              /**< Initialize the serial module. */
-    SERIAL_STATE_CLOSED,            /**< The serial module is closed. */
-    SERIAL_STATE_OPENED,            /**< The serial module is opened and running normally. */
-    SERIAL_STATE_ERROR              /**< Throw an error message if it occurred in the interrupt handler. */
-} serial_state_t;
-
-/**
- * @brief Function to initialize the serial port.
- */
-void serial_init(void);
-
-/**
- * @brief Function to accomplish serial port tasks.
- *
- * @details This should be called repeatedly from the main loop.
- */
-void serial_tasks(void);
-
-/**
- * @brief Try and open the serial port, if it is not already open.
- *
- * @retval  True if the serial port was opened (always return true).
- */
-bool serial_try_open(void);
-
-/**
- * @brief Try and close the serial port, if it is not already closed.
- *
- * @retval  True if the serial port was able to close.
- */
-bool serial_try_close(void);
-
-/**
- * @brief Function to try and return a line received over the serial port.
- *
- * @param[out]  p_buffer        A pointer to the buffer where data will be copied.
- * @param[in]   size            The maximum size of the supplied buffer.
- *
- * @retval      The number of bytes copied into the buffer.
- */
-uint32_t serial_try_read_line(uint8_t * p_buffer, uint32_t size);
-
-/**
- * @brief Function to return all of the data received over the serial port.
- *
- * @param[out]  p_buffer        A pointer to the buffer where data will be copied.
- * @param[in]   size            The maximum size of the supplied buffer.
- *
- * @retval      The number of bytes copied into the buffer.
- */
-uint32_t serial_read_existing(uint8_t * p_buffer, uint32_t size);
-
-/**
- * @brief Function to try and write a given number of bytes over the serial port.
- *
- * @param[in]   p_buffer        A pointer to the buffer that contains the data to transmit.
- * @param[in]   size            The number of bytes to send in the buffer.
- */
-void serial_write(uint8_t * p_buffer, uint32_t length);
-
-/**
- * @brief   Function to read bytes from the uart fifo and put them into our receive buffer.
- *
- * @retval      The number of bytes moved from the fifo to the receive buffer.
- */
-static uint32_t serial_fifo_to_rx_buffer(void);
-
-#endif //SERIAL_H__
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall serial.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall serial communication module.
+ *
+ * The basic philosophy is that the serial_tasks will be called from the main loop
+ * and see if there are any bytes available from the SDKs uart module. If there are
+ * read them and put them into a receive buffer.
+ *
+ * The receive ring is made available to be read from, a line at a time or in place.
+ *
+ * Writes are copied into a transmit ring and return right away. The ring is moved into
+ * the uart fifo as it empties, from the uart interrupt. What happens when a write
+ * doesn't fit in the ring is set by the transmit policy.
+ *
+ * When a peer is using our shell over BLE the transmit ring is drained into notifications
+ * by the service server instead of the uart, and the bytes the peer writes are added to the
+ * receive buffer as if they had come from the uart.
+ */
+
+#ifndef SERIAL_H__
+#define SERIAL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ring.h"
+
+#define SERIAL_DEFAULT_BAUD      115200               /**< The rate the port opens at, and falls back to. */
+#define SERIAL_MAX_BAUD          1000000              /**< The fastest rate that can be negotiated, the buffers are sized for it. */
+#define SERIAL_MAX_LATENCY_MS    4                    /**< The longest the main loop may leave the uart fifo alone. */
+#define SERIAL_BYTES_PER_MS(BAUD) ((BAUD) / 10 / 1000) /**< 8 data bits plus a start and a stop bit. */
+#define SERIAL_BAUD_CONFIRM_MS   2000                 /**< How long the peer has to confirm a new rate before we fall back. */
+#define SERIAL_BAUD_POLL_MS      10                   /**< How often to check on a rate change in progress. */
+
+#define UART_TX_BUF_SIZE         256                  /**< UART TX buffer size. */
+#define UART_RX_BUF_SIZE         512                  /**< UART RX buffer size, a power of two that holds SERIAL_MAX_LATENCY_MS at SERIAL_MAX_BAUD. */
+#define SERIAL_RX_BUF_SIZE       256                  /**< Receive ring size, a power of two. */
+#define SERIAL_TX_BUF_SIZE       256                  /**< Transmit ring size, a power of two, on top of the UART TX buffer. */
+#define SERIAL_FLOW_CONTROL_BUF  (SERIAL_RX_BUF_SIZE - sizeof("\r"))
+
+#define SERIAL_TX_EMPTY_TIMEOUT  (CLOCK_MS_IN_TICKS(2))
+
+/**
+ * @brief serial module states.
+ */
+typedef enum
+{
+    SERIAL_STATE_INIT,              /**< Initialize the serial module. */
+    SERIAL_STATE_CLOSED,            /**< The serial module is closed. */
+    SERIAL_STATE_OPENED,            /**< The serial module is opened and running normally. */
+    SERIAL_STATE_ERROR              /**< Throw an error message if it occurred in the interrupt handler. */
+} serial_state_t;
+
+/**
+ * @brief What to do with a write that doesn't fit in the transmit ring.
+ */
+typedef enum
+{
+    SERIAL_TX_POLICY_BLOCK,         /**< Wait for the uart to make room. */
+    SERIAL_TX_POLICY_DROP_NEWEST,   /**< Drop the bytes that don't fit. */
+    SERIAL_TX_POLICY_OVERWRITE_OLDEST /**< Drop the oldest bytes in the ring to make room. */
+} serial_tx_policy_t;
+
+/**
+ * @brief A contiguous section of the receive or transmit ring, the size is in bytes and can be 0.
+ */
+typedef ring_span_t serial_span_t;
+
+#define SERIAL_SPAN_COUNT        RING_SPAN_COUNT      /**< The received bytes are at most split in two by the rollover. */
+
+/**
+ * @brief A supported baud rate.
+ */
+typedef struct
+{
+    uint32_t    baud;               /**< The rate in bits per second. */
+    uint32_t    config;             /**< The value for the UART BAUDRATE register. */
+} serial_baud_t;
+
+/**
+ * @brief Counts of the errors reported by the uart driver.
+ */
+typedef struct
+{
+    uint32_t    overrun;            /**< A byte arrived before the previous one was read. */
+    uint32_t    parity;
+    uint32_t    framing;            /**< No stop bit, usually the two sides are at different rates. */
+    uint32_t    break_condition;
+    uint32_t    rx_fifo_full;       /**< The uart RX fifo was full. */
+    uint32_t    baud_fallbacks;     /**< A new rate was never confirmed so we went back to the default. */
+} serial_error_counts_t;
+
+/**
+ * @brief Function to initialize the serial port.
+ */
+void serial_init(void);
+
+/**
+ * @brief Function to accomplish serial port tasks.
+ *
+ * @details This should be called repeatedly from the main loop.
+ */
+void serial_tasks(void);
+
+/**
+ * @brief Try and open the serial port, if it is not already open.
+ *
+ * @retval  True if the serial port was opened (always return true).
+ */
+bool serial_try_open(void);
+
+/**
+ * @brief Try and close the serial port, if it is not already closed.
+ *
+ * @retval  True if the serial port was able to close.
+ */
+bool serial_try_close(void);
+
+/**
+ * @brief Function to try and return a line received over the serial port.
+ *
+ * @details Only the bytes that arrived since the last call are searched for the end of a
+ *          line. A line that doesn't fit in the supplied buffer is cut short, and if there
+ *          is room the line is followed by a terminating zero.
+ *
+ * @param[out]  p_buffer        A pointer to the buffer where data will be copied.
+ * @param[in]   size            The maximum size of the supplied buffer.
+ *
+ * @retval      The number of bytes copied into the buffer.
+ */
+uint32_t serial_try_read_line(uint8_t * p_buffer, uint32_t size);
+
+/**
+ * @brief Function to return all of the data received over the serial port.
+ *
+ * @param[out]  p_buffer        A pointer to the buffer where data will be copied.
+ * @param[in]   size            The maximum size of the supplied buffer.
+ *
+ * @retval      The number of bytes copied into the buffer.
+ */
+uint32_t serial_read_existing(uint8_t * p_buffer, uint32_t size);
+
+/**
+ * @brief Function to start changing the baud rate.
+ *
+ * @details The handshake is:
+ *          - the peer asks for a new rate at the current rate, and we answer at the current rate,
+ *          - once everything has been sent we switch, and the peer switches when it gets the answer,
+ *          - the peer confirms at the new rate with serial_confirm_baud, or we go back to
+ *            SERIAL_DEFAULT_BAUD after SERIAL_BAUD_CONFIRM_MS. A rate that doesn't work on a
+ *            board can't lock anyone out.
+ *
+ * @param[in]   baud            The new rate in bits per second.
+ *
+ * @retval      True if the rate is supported and the change was started.
+ */
+bool serial_request_baud(uint32_t baud);
+
+/**
+ * @brief Function to confirm that the current baud rate works, so that we stay on it.
+ */
+void serial_confirm_baud(void);
+
+/**
+ * @brief Function to get the current baud rate.
+ *
+ * @retval      The rate in bits per second.
+ */
+uint32_t serial_get_baud(void);
+
+/**
+ * @brief Function to get the counts of the errors reported by the uart driver.
+ *
+ * @retval      A pointer to the error counts.
+ */
+serial_error_counts_t const * serial_get_error_counts(void);
+
+/**
+ * @brief Function to look at the received bytes in place, without copying or removing them.
+ *
+ * @details The bytes are returned as two sections, the one before the rollover of the receive
+ *          buffer and the one after it. They stay valid until serial_consume, or any of the read
+ *          functions, is called.
+ *
+ * @param[out]  p_spans         A pointer to SERIAL_SPAN_COUNT spans to fill in.
+ *
+ * @retval      The total number of bytes in the spans.
+ */
+uint32_t serial_peek(serial_span_t * p_spans);
+
+/**
+ * @brief Function to remove bytes that were looked at with serial_peek from the receive buffer.
+ *
+ * @param[in]   size            The number of bytes that were used.
+ */
+void serial_consume(uint32_t size);
+
+/**
+ * @brief Function to add bytes to the receive buffer as if they had come from the uart.
+ *
+ * @param[in]   p_data          A pointer to the bytes.
+ * @param[in]   size            The number of bytes.
+ *
+ * @retval      The number of bytes that fit, the rest are thrown away.
+ */
+uint32_t serial_receive(uint8_t const * p_data, uint32_t size);
+
+/**
+ * @brief Function to get how many more bytes fit in the receive buffer.
+ *
+ * @details This is what keeps RTS high on the uart, and the credits given to a BLE peer.
+ *
+ * @retval      The number of free bytes in the receive buffer.
+ */
+uint32_t serial_get_rx_room(void);
+
+/**
+ * @brief Function to send the transmit ring to a BLE peer instead of the uart.
+ *
+ * @details While remote, the service module is made pending when there is something to send,
+ *          and takes it with serial_tx_peek and serial_tx_consume. A write that doesn't fit is
+ *          dropped rather than blocking, since the ring can only drain from the main loop.
+ *
+ * @param[in]   is_remote       True to send to the BLE peer, false to go back to the uart.
+ */
+void serial_set_tx_remote(bool is_remote);
+
+/**
+ * @brief Function to look at the bytes waiting in the transmit ring in place.
+ *
+ * @param[out]  p_spans         A pointer to SERIAL_SPAN_COUNT spans to fill in.
+ *
+ * @retval      The total number of bytes in the spans.
+ */
+uint32_t serial_tx_peek(serial_span_t * p_spans);
+
+/**
+ * @brief Function to remove bytes that were sent from the transmit ring.
+ *
+ * @param[in]   size            The number of bytes that were sent.
+ */
+void serial_tx_consume(uint32_t size);
+
+/**
+ * @brief Function to try and write a given number of bytes over the serial port.
+ *
+ * @details The bytes are copied into the transmit ring, so this returns before they are sent
+ *          unless the policy is to block and the ring is full.
+ *
+ * @param[in]   p_buffer        A pointer to the buffer that contains the data to transmit.
+ * @param[in]   size            The number of bytes to send in the buffer.
+ */
+void serial_write(uint8_t * p_buffer, uint32_t length);
+
+/**
+ * @brief Function to set what happens to a write that doesn't fit in the transmit ring.
+ *
+ * @param[in]   policy          The new policy.
+ *
+ * @retval      The previous policy, so it can be put back.
+ */
+serial_tx_policy_t serial_set_tx_policy(serial_tx_policy_t policy);
+
+/**
+ * @brief Function to get how many bytes can be written without the transmit policy kicking in.
+ *
+ * @retval      The number of free bytes in the transmit ring.
+ */
+uint32_t serial_get_tx_room(void);
+
+/**
+ * @brief Function to get the number of bytes dropped because they didn't fit in the transmit ring.
+ *
+ * @retval      The number of newest bytes that were dropped.
+ */
+uint32_t serial_get_tx_dropped_count(void);
+
+/**
+ * @brief Function to get the number of bytes overwritten in the transmit ring before they were sent.
+ *
+ * @retval      The number of oldest bytes that were dropped.
+ */
+uint32_t serial_get_tx_overwritten_count(void);
+
+/**
+ * @brief Function to get the most bytes that have been waiting in the receive ring at once.
+ *
+ * @retval      The high water mark of the receive ring.
+ */
+uint32_t serial_get_rx_high_water(void);
+
+/**
+ * @brief Function to get the most bytes that have been waiting in the transmit ring at once.
+ *
+ * @retval      The high water mark of the transmit ring.
+ */
+uint32_t serial_get_tx_high_water(void);
+
+/**
+ * @brief   Function to read bytes from the uart fifo and put them into our receive buffer.
+ *
+ * @retval      The number of bytes moved from the fifo to the receive buffer.
+ */
+static uint32_t serial_fifo_to_rx_buffer(void);
+
+/**
+ * @brief   Function to carry out a baud rate change that was requested, or fall back if it wasn't confirmed.
+ */
+static void serial_baud_tasks(void);
+
+/**
+ * @brief   Function to find a byte in a pair of spans.
+ *
+ * @param[in]   p_spans         The spans.
+ * @param[in]   offset          The offset of the byte from the start of the first span.
+ *
+ * @retval      A pointer to the byte.
+ */
+static uint8_t * serial_span_at(serial_span_t const * p_spans, uint32_t offset);
+
+/**
+ * @brief   Function to find the UART register value of a baud rate.
+ *
+ * @param[in]   baud            The rate in bits per second.
+ *
+ * @retval      The supported rate, or NULL if it isn't supported.
+ */
+static serial_baud_t const * serial_find_baud(uint32_t baud);
+
+/**
+ * @brief   Function to close the uart and open it again at a new rate.
+ *
+ * @param[in]   baud            The new rate in bits per second, it must be supported.
+ */
+static void serial_switch_baud(uint32_t baud);
+
+/**
+ * @brief   Function to check if everything written has been sent.
+ *
+ * @retval      True if the transmit ring and the uart fifo are empty.
+ */
+static bool serial_is_tx_idle(void);
+
+/**
+ * @brief   Function to remove bytes from the front of the receive buffer.
+ *
+ * @param[in]   size            The number of bytes to remove.
+ */
+static void serial_rx_buffer_consume(uint32_t size);
+
+/**
+ * @brief   Function to find the first carriage return or new line.
+ *
+ * @param[in]   p_data          A pointer to the bytes to search.
+ * @param[in]   size            The number of bytes to search.
+ *
+ * @retval      A pointer to the end of the line, or NULL if there isn't one.
+ */
+static uint8_t * serial_find_line_end(uint8_t * p_data, uint32_t size);
+
+/**
+ * @brief   Function to move bytes from the transmit ring into the uart fifo, until either is full or empty.
+ *
+ * @details This is called from both the main loop and the uart interrupt.
+ */
+static void serial_tx_buffer_to_fifo(void);
+
+#endif //SERIAL_H__
+
+/** @} */
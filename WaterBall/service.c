@@ -1,92 +1,150 @@
-/**
- * @file
- * @defgroup WaterBall service.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall service module.
- */
-
-#include "app_button.h"
-#include "app_error.h"
-#include "ble_srv_common.h"
-#include "service.h"
-#include "service_client.h"
-#include "service_server.h"
-#include "sdk_common.h"
-
-static service_state_t         m_service_state;
-
-
-void service_on_ble_evt(ble_evt_t * p_ble_evt)
-{
-    switch (p_ble_evt->header.evt_id)
-    {
-        case BLE_GAP_EVT_CONNECTED:
-        {
-            break;
-        }
-        case BLE_GAP_EVT_DISCONNECTED:
-        {
-            break;
-        }
-    }
-
-    service_client_on_ble_evt(p_ble_evt);
-    service_server_on_ble_evt(p_ble_evt);
-}
-
-
-void service_init(void)
-{
-    service_client_init();
-    service_server_init();
-    m_service_state = SERVICE_STATE_INIT;
-}
-
-
-void service_tasks(void)
-{
-    switch (m_service_state)
-    {
-        case SERVICE_STATE_INIT:
-        {
-            m_service_state = SERVICE_STATE_READY;
-            break;
-        }
-        case SERVICE_STATE_READY:
-        {
-            break;
-        }
-        case SERVICE_STATE_ERROR:
-        {
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-
-    service_client_tasks();
-    service_server_tasks();
-}
-
-
-void service_try_connect(void)
-{
-    service_client_try_connect();
-}
-
-
-bool service_is_client(void)
-{
-    return service_client_is_connected();
-}
-
-
-bool service_is_server(void)
-{
-    return service_server_is_connected();
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall service.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall service module.
+ */
+
+#include "app_button.h"
+#include "app_error.h"
+#include "ble_srv_common.h"
+#include "clock.h"
+#include "service.h"
+#include "service_client.h"
+#include "service_server.h"
+#include "sdk_common.h"
+
+static service_state_t         m_service_state;
+static service_latency_t       m_score_latency = { .min_ticks = UINT32_MAX };
+
+
+void service_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            break;
+        }
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            break;
+        }
+    }
+
+    service_client_on_ble_evt(p_ble_evt);
+    service_server_on_ble_evt(p_ble_evt);
+}
+
+
+void service_init(void)
+{
+    service_client_init();
+    service_server_init();
+    m_service_state = SERVICE_STATE_INIT;
+}
+
+
+void service_tasks(void)
+{
+    switch (m_service_state)
+    {
+        case SERVICE_STATE_INIT:
+        {
+            m_service_state = SERVICE_STATE_READY;
+            break;
+        }
+        case SERVICE_STATE_READY:
+        {
+            break;
+        }
+        case SERVICE_STATE_ERROR:
+        {
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+
+    service_client_tasks();
+    service_server_tasks();
+}
+
+
+void service_try_connect(void)
+{
+    service_client_try_connect();
+}
+
+
+bool service_is_client(void)
+{
+    return service_client_is_connected();
+}
+
+
+bool service_is_server(void)
+{
+    return service_server_is_connected();
+}
+
+
+void service_score_latency_start(void)
+{
+    if (m_score_latency.is_pending)
+    {
+        // The acknowledgement of the previous update is probably still waiting in the event queue.
+        m_score_latency.superseded++;
+    }
+
+    m_score_latency.start_ticks = clock_get_ticks();
+    m_score_latency.is_pending = true;
+}
+
+
+void service_score_latency_stop(void)
+{
+    if (!m_score_latency.is_pending)
+    {
+        return;
+    }
+
+    uint32_t ticks = clock_ticks_since(m_score_latency.start_ticks);
+    m_score_latency.is_pending = false;
+    m_score_latency.count++;
+    m_score_latency.total_ticks += ticks;
+    m_score_latency.min_ticks = MIN(m_score_latency.min_ticks, ticks);
+    m_score_latency.max_ticks = MAX(m_score_latency.max_ticks, ticks);
+
+    uint32_t bucket = 0;
+    uint32_t bucket_ms = SERVICE_LATENCY_FIRST_BUCKET_MS;
+    uint32_t ms = CLOCK_TICKS_IN_MS(ticks);
+    while ((ms >= bucket_ms) && (bucket < (SERVICE_LATENCY_BUCKETS - 1)))
+    {
+        bucket++;
+        bucket_ms <<= 1;
+    }
+
+    m_score_latency.histogram[bucket]++;
+}
+
+
+void service_score_latency_lost(void)
+{
+    if (m_score_latency.is_pending)
+    {
+        m_score_latency.is_pending = false;
+        m_score_latency.lost++;
+    }
+}
+
+
+service_latency_t const * service_get_score_latency(void)
+{
+    return &m_score_latency;
+}
+
+/** @} */
@@ -1,105 +1,215 @@
-/**
- * @file
- * @defgroup WaterBall service.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall service module.
- *
- * Main interface for the service server and client.
- */
-
-#ifndef SERVICE_H__
-#define SERVICE_H__
-
-#include <stdbool.h>
-#include <stdint.h>
-#include "ble.h"
-#include "ble_types.h"
-
-#define MAX_CONNECTING_CYCLES                           (8)
-#define SERVICE_MAX_TX_BYTES                            (GATT_MTU_SIZE_DEFAULT - sizeof(uint8_t) - sizeof(uint16_t))    /**< The opcode and handle take up a few bytes of the MTU. */
-
-#define SERVICE_BASE_UUID_128                           { 0x12, 0x9A, 0xF0, 0x11, 0xA1, 0x09, 0x2F, 0xF4, 0xE1, 0x00, 0x6A, 0x11, 0xBA, 0xE9, 0xA7, 0x44 }
-#define SERVICE_BASE_UUID                               (0xE9BA)
-#define SERVICE_INFO_UUID                               (0x10F0)
-#define SERVICE_SERVER_SCORE_UUID                       (0x15C0)
-#define SERVICE_CLIENT_SCORE_UUID                       (0x25C0)
-#define SERVICE_GAME_STATE_UUID                         (0x57A7)
-#define SERVICE_CURRENT_TIME_UUID                       (0xCE77)
-#define SERVICE_GAME_TIME_UUID                          (0x7100)
-#define SERVICE_VIBRATION_UUID                          (0x1BA7)
-#define SERVICE_HOLE_UUID                               (0x401E)
-#define SERVICE_TARGET_SCORE_UUID                       (0x7AE7)
-
-#define IS_SERVICE_CLIENT                               (service_is_client())
-#define IS_SERVICE_SERVER                               (service_is_server())
-
-#define SERVICE_UUID(UUID)                              { UUID, BLE_UUID_TYPE_BLE }
-#define CONFIG_HANDLE(HANDLE)                           (HANDLE + 1)
-
-/**
- * @brief   service server module states.
- */
-typedef enum
-{
-    SERVICE_STATE_INIT = 0,             /**< Initialize the service server module. */
-    SERVICE_STATE_READY,               /**< The service server module is running normally. */
-    SERVICE_STATE_ERROR                /**< Throw an error message if it occurred in the interrupt handler. */
-} service_state_t;
-
-/**
- * @brief   service info structure.
- */
-typedef struct
-{
-    uint16_t    server_score_handle;
-    uint16_t    client_score_handle;
-    uint16_t    game_state_handle;
-    uint16_t    current_time_handle;
-    uint16_t    game_time_handle;
-    uint16_t    vibration_handle;
-    uint16_t    hole_handle;
-    uint16_t    target_score_handle;
-} service_info_t;
-
-/**
- * @brief   Function called on ble events.
- *
- * @param[in]   p_ble_evt           The event data.
- */
-void service_on_ble_evt(ble_evt_t * p_ble_evt);
-
-/**
- * @brief   Function to initialize the service module.
- */
-void service_init(void);
-
-/**
- * @brief   Function to accomplish service module tasks.
- *
- * @details This should be called repeatedly from the main loop.
- */
-void service_tasks(void);
-
-/**
- * @brief   Try to connect as a client, this function gives access to service_client_try_connect command.
- */
-void service_try_connect(void);
-
-/**
- * @brief   Is this device a service client, this function gives access to service_client_is_connected.
- *
- * @retval      True if the service_client module is in the connected state.
- */
-bool service_is_client(void);
-
-/**
- * @brief   Is this device a service server, this function gives access to service_server_is_connected.
- *
- * @retval      True if the service_server module is in the connected state.
- */
-bool service_is_server(void);
-
-#endif //SERVICE_H__
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall service.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall service module.
+ *
+ * Main interface for the service server and client.
+ *
+ * Next to the game characteristics the service has a serial bridge, so that the central
+ * can reach the shell and telemetry of the peripheral. The server notifies its serial
+ * transmit ring on the bridge TX characteristic, and the client writes its serial input
+ * to the bridge RX characteristic without response. Each packet is as full as the MTU
+ * allows, and more are sent as the SoftDevice reports the previous ones sent.
+ *
+ * Both directions use credits so that nothing is dropped: each side tells the other the
+ * total number of bytes it may have sent so far, on the bridge credits characteristic.
+ * The server grants the room in its serial receive buffer, the same thing that holds RTS
+ * high on its uart, and the client grants the room in its serial transmit ring. A client
+ * that is out of credits leaves its serial input in the receive buffer, which in turn
+ * holds RTS high to the computer.
+ *
+ * The current time characteristic carries the clock offset exchange of the sync module,
+ * and the game state indication carries the time that play starts on the server clock,
+ * so that the client can count down to the same moment.
+ */
+
+#ifndef SERVICE_H__
+#define SERVICE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ble.h"
+#include "ble_types.h"
+
+#define SERVICE_CONNECTING_TIMEOUT_MS                   (100)       /**< How long the server waits in the connecting state before it gives up. */
+#define SERVICE_MAX_TX_BYTES                            (GATT_MTU_SIZE_DEFAULT - sizeof(uint8_t) - sizeof(uint16_t))    /**< The opcode and handle take up a few bytes of the MTU. */
+
+#define SERVICE_BASE_UUID_128                           { 0x12, 0x9A, 0xF0, 0x11, 0xA1, 0x09, 0x2F, 0xF4, 0xE1, 0x00, 0x6A, 0x11, 0xBA, 0xE9, 0xA7, 0x44 }
+#define SERVICE_BASE_UUID                               (0xE9BA)
+#define SERVICE_INFO_UUID                               (0x10F0)
+#define SERVICE_SERVER_SCORE_UUID                       (0x15C0)
+#define SERVICE_CLIENT_SCORE_UUID                       (0x25C0)
+#define SERVICE_GAME_STATE_UUID                         (0x57A7)
+#define SERVICE_CURRENT_TIME_UUID                       (0xCE77)
+#define SERVICE_GAME_TIME_UUID                          (0x7100)
+#define SERVICE_VIBRATION_UUID                          (0x1BA7)
+#define SERVICE_HOLE_UUID                               (0x401E)
+#define SERVICE_TARGET_SCORE_UUID                       (0x7AE7)
+#define SERVICE_PROFILE_UUID                            (0x9F0F)
+#define SERVICE_BRIDGE_TX_UUID                          (0xB7D0)
+#define SERVICE_BRIDGE_RX_UUID                          (0xB7D1)
+#define SERVICE_BRIDGE_CREDITS_UUID                     (0xB7DC)
+
+#define IS_SERVICE_CLIENT                               (service_is_client())
+#define IS_SERVICE_SERVER                               (service_is_server())
+
+#define SERVICE_UUID(UUID)                              { UUID, BLE_UUID_TYPE_BLE }
+#define CONFIG_HANDLE(HANDLE)                           (HANDLE + 1)
+
+#define SERVICE_LATENCY_BUCKETS                         (8)                 /**< Bucket n counts latencies below 8 ms * 2^n, the last bucket counts everything longer. */
+#define SERVICE_LATENCY_FIRST_BUCKET_MS                 (8)
+
+#define SERVICE_BRIDGE_CREDIT_STEP                      (SERVICE_MAX_TX_BYTES)  /**< Only grant more credits once there is room for another full packet. */
+
+/**
+ * @brief   service server module states.
+ */
+typedef enum
+{
+    SERVICE_STATE_INIT = 0,             /**< Initialize the service server module. */
+    SERVICE_STATE_READY,               /**< The service server module is running normally. */
+    SERVICE_STATE_ERROR                /**< Throw an error message if it occurred in the interrupt handler. */
+} service_state_t;
+
+/**
+ * @brief   service info structure.
+ */
+typedef struct
+{
+    uint16_t    server_score_handle;
+    uint16_t    client_score_handle;
+    uint16_t    game_state_handle;
+    uint16_t    current_time_handle;
+    uint16_t    game_time_handle;
+    uint16_t    vibration_handle;
+    uint16_t    hole_handle;
+    uint16_t    target_score_handle;
+    uint16_t    bridge_tx_handle;
+    uint16_t    bridge_rx_handle;
+    uint16_t    bridge_credits_handle;
+} service_info_t;
+
+/**
+ * @brief   Serial bridge state of one side of the link.
+ *
+ * @details The byte counts are totals since the bridge was started, they are allowed to wrap.
+ */
+typedef struct
+{
+    bool        is_active;
+    uint32_t    tx_sent;                                    /**< Bytes sent to the peer. */
+    uint32_t    tx_limit;                                   /**< The total the peer has given us credits for. */
+    uint32_t    rx_received;                                /**< Bytes received from the peer. */
+    uint32_t    rx_granted;                                 /**< The total we have given the peer credits for. */
+    uint32_t    rx_dropped;                                 /**< Bytes the peer sent beyond its credits, that didn't fit. */
+    uint32_t    tx_packets;
+    uint32_t    stalls;                                     /**< Times there was something to send but no credits or SoftDevice buffers. */
+} service_bridge_t;
+
+/**
+ * @brief   Round trip latency statistics of an update sent to the peer.
+ *
+ * @details The latency is measured from handing the update to the SoftDevice until the
+ *          peer acknowledges it - the indication confirmation on the server, or the write
+ *          response on the client.
+ */
+typedef struct
+{
+    bool        is_pending;                                 /**< True while an update is waiting for its acknowledgement. */
+    uint32_t    start_ticks;                                /**< When the pending update was sent. */
+    uint32_t    count;                                      /**< The number of acknowledged updates. */
+    uint32_t    lost;                                       /**< Updates that were never acknowledged (timeout or disconnect). */
+    uint32_t    superseded;                                 /**< Updates sent before the acknowledgement of the previous one was handled. */
+    uint32_t    min_ticks;
+    uint32_t    max_ticks;
+    uint32_t    total_ticks;
+    uint32_t    histogram[SERVICE_LATENCY_BUCKETS];
+} service_latency_t;
+
+/**
+ * @brief   One sample of the clock offset exchange, the value of the current time characteristic.
+ *
+ * @details The client writes only the request time, the server indicates all three. Each
+ *          time is the low 32 bits of the 64 bit clock of the side that took it.
+ */
+typedef struct
+{
+    uint32_t    request_ticks;                              /**< T1, the connection event the request went out in, on the client. */
+    uint32_t    receive_ticks;                              /**< T2, when the request arrived, on the server. */
+    uint32_t    response_ticks;                             /**< T3, the connection event the answer goes out in, on the server. */
+} service_current_time_t;
+
+/**
+ * @brief   The value of the game state characteristic.
+ */
+typedef struct
+{
+    uint32_t    state;                                      /**< A game_state_t. */
+    uint32_t    start_ticks;                                /**< When play starts, the low 32 bits of the 64 bit server clock. */
+} service_game_state_t;
+
+/**
+ * @brief   Function called on ble events.
+ *
+ * @param[in]   p_ble_evt           The event data.
+ */
+void service_on_ble_evt(ble_evt_t * p_ble_evt);
+
+/**
+ * @brief   Function to initialize the service module.
+ */
+void service_init(void);
+
+/**
+ * @brief   Function to accomplish service module tasks.
+ *
+ * @details This should be called repeatedly from the main loop.
+ */
+void service_tasks(void);
+
+/**
+ * @brief   Try to connect as a client, this function gives access to service_client_try_connect command.
+ */
+void service_try_connect(void);
+
+/**
+ * @brief   Is this device a service client, this function gives access to service_client_is_connected.
+ *
+ * @retval      True if the service_client module is in the connected state.
+ */
+bool service_is_client(void);
+
+/**
+ * @brief   Is this device a service server, this function gives access to service_server_is_connected.
+ *
+ * @retval      True if the service_server module is in the connected state.
+ */
+bool service_is_server(void);
+
+/**
+ * @brief   Note that a score update was just sent to the peer.
+ */
+void service_score_latency_start(void);
+
+/**
+ * @brief   Note that the peer acknowledged the last score update.
+ */
+void service_score_latency_stop(void);
+
+/**
+ * @brief   Note that the last score update will never be acknowledged.
+ */
+void service_score_latency_lost(void);
+
+/**
+ * @brief   Get the round trip latency statistics of the score updates.
+ *
+ * @retval      A pointer to the statistics.
+ */
+service_latency_t const * service_get_score_latency(void);
+
+#endif //SERVICE_H__
+
+/** @} */
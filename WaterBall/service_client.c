@@ -1,289 +1,491 @@
-/**
- * @file
- * @defgroup WaterBall service_client.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall game client module.
- */
-
-#include "app_error.h"
-#include "app_util_platform.h"
-#include "ble_hci.h"
-#include "ble_srv_common.h"
-#include "game.h"
-#include "service.h"
-#include "service_client.h"
-#include "sdk_common.h"
-
-static service_client_state_t  m_service_client_state;
-static ble_uuid_t           m_service_uuid = { SERVICE_BASE_UUID, BLE_UUID_TYPE_VENDOR_BEGIN };
-static uint16_t             m_service_handle;
-static uint16_t             m_conn_handle;
-static service_info_t       m_info = { 0 };
-static uint32_t             m_server_score;
-static uint32_t             m_current_time;
-static uint32_t             m_game_time;
-static uint32_t             m_vibration;
-static uint32_t             m_hole;
-static uint32_t             m_target_score;
-static uint32_t             m_time;
-
-
-void service_client_on_ble_evt(ble_evt_t * p_ble_evt)
-{
-    ble_gattc_evt_t * p_ble_gattc_evt = &p_ble_evt->evt.gattc_evt;
-
-    switch (p_ble_evt->header.evt_id)
-    {
-        case BLE_GAP_EVT_CONNECTED:
-        {
-            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-            break;
-        }
-        case BLE_GAP_EVT_DISCONNECTED:
-        {
-            m_conn_handle = BLE_CONN_HANDLE_INVALID;
-            m_service_client_state = SERVICE_CLIENT_STATE_READY;
-            break;
-        }
-        case BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP:
-        {
-            if (BLE_GATT_STATUS_SUCCESS == p_ble_gattc_evt->gatt_status)
-            {
-                // If we found it then save the handle and search again - to make sure we got the last one.
-                ble_gattc_evt_prim_srvc_disc_rsp_t * p_prim_srvc_disc_rsp = &p_ble_gattc_evt->params.prim_srvc_disc_rsp;
-                uint16_t count = p_prim_srvc_disc_rsp->count;
-                if (0 == count)
-                {
-                    return;
-                }
-
-                m_service_handle = p_prim_srvc_disc_rsp->services[count - 1].handle_range.start_handle;
-                sd_ble_gattc_primary_services_discover(m_conn_handle, m_service_handle + 1, &m_service_uuid);
-            }
-            else if (BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND == p_ble_gattc_evt->gatt_status)
-            {
-                // If we didn't find the service, but we found one previously then we are connected.
-                if (BLE_CONN_HANDLE_INVALID != m_service_handle)
-                {
-                    sd_ble_gattc_read(m_conn_handle, m_service_handle + SERVICE_INFO_ATTR_OFFSET, 0);
-                }
-                else
-                {
-                    // We never found the service so just go back to the SERVICE_CLIENT_STATE_READY state - connection failed.
-                    m_service_client_state = SERVICE_CLIENT_STATE_READY;
-                }
-            }
-
-            break;
-        }
-        case BLE_GATTC_EVT_READ_RSP:
-        {
-            // We got a response from the INFO characteristic, copy them into m_info.
-            ble_gattc_evt_read_rsp_t * p_read_rsp = &p_ble_gattc_evt->params.read_rsp;
-            if ((m_service_handle + SERVICE_INFO_ATTR_OFFSET) == p_read_rsp->handle)
-            {
-                memcpy(((uint8_t *)&m_info) + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
-
-                // Enable server score and game time indicate.
-                uint16_t write_value = BLE_GATT_HVX_INDICATION;
-                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.server_score_handle), sizeof(write_value), &write_value);
-                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.game_time_handle), sizeof(write_value), &write_value);
-                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.game_state_handle), sizeof(write_value), &write_value);
-
-                sd_ble_gattc_read(m_conn_handle, m_info.game_time_handle, 0);
-            }
-            else if (m_info.game_time_handle == p_read_rsp->handle)
-            {
-                memcpy(&m_game_time + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
-                sd_ble_gattc_read(m_conn_handle, m_info.vibration_handle, 0);
-            }
-            else if (m_info.vibration_handle == p_read_rsp->handle)
-            {
-                memcpy(&m_vibration + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
-                sd_ble_gattc_read(m_conn_handle, m_info.hole_handle, 0);
-            }
-            else if (m_info.hole_handle == p_read_rsp->handle)
-            {
-                memcpy(&m_hole + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
-                sd_ble_gattc_read(m_conn_handle, m_info.target_score_handle, 0);
-            }
-            else if (m_info.target_score_handle == p_read_rsp->handle)
-            {
-                memcpy(&m_target_score + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
-            }
-
-            m_service_client_state = SERVICE_CLIENT_STATE_CONNECTED;
-            break;
-        }
-        case BLE_GATTC_EVT_WRITE_RSP:
-        {
-            break;
-        }
-        case BLE_GATTC_EVT_HVX:
-        {
-            ble_gattc_evt_hvx_t * p_hvx = &p_ble_gattc_evt->params.hvx;
-            if (p_hvx->handle == m_info.server_score_handle)
-            {
-                memcpy(&m_server_score, p_hvx->data, p_hvx->len);
-            }
-            else if (p_hvx->handle == m_info.game_time_handle)
-            {
-                memcpy(&m_time, p_hvx->data, p_hvx->len);
-            }
-            else if (p_hvx->handle == m_info.game_state_handle)
-            {
-                uint32_t state;
-                memcpy(&state, p_hvx->data, p_hvx->len);
-                game_set_state((game_state_t)state);
-            }
-
-            if (BLE_GATT_HVX_INDICATION == p_hvx->type)
-            {
-                // Send confirmation that we received the indicate message.
-                sd_ble_gattc_hv_confirm(m_conn_handle, p_hvx->handle);
-            }
-
-            break;
-        }
-        case BLE_GATTC_EVT_TIMEOUT:
-        {
-            // Something has timed out - Bluetooth Spec 4.1, Volume 3, Part F, Chapter 2 states
-            // that we must now break the connection.
-            APP_ERROR_CHECK(sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION));
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-void service_client_init(void)
-{
-    m_conn_handle = BLE_CONN_HANDLE_INVALID;
-    m_service_client_state = SERVICE_CLIENT_STATE_INIT;
-}
-
-
-void service_client_tasks(void)
-{
-    switch (m_service_client_state)
-    {
-        case SERVICE_CLIENT_STATE_INIT:
-        {
-            m_service_client_state = SERVICE_CLIENT_STATE_READY;
-            break;
-        }
-        case SERVICE_CLIENT_STATE_READY:
-        {
-            break;
-        }
-        case SERVICE_CLIENT_STATE_CONNECTING:
-        {
-            break;
-        }
-        case SERVICE_CLIENT_STATE_CONNECTED:
-        {
-            break;
-        }
-        case SERVICE_CLIENT_STATE_ERROR:
-        {
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-bool service_client_is_connected(void)
-{
-    return m_service_client_state == SERVICE_CLIENT_STATE_CONNECTED;
-}
-
-
-void service_client_try_connect(void)
-{
-    if (BLE_CONN_HANDLE_INVALID == m_conn_handle)
-    {
-        return;
-    }
-
-    APP_ERROR_CHECK(sd_ble_gattc_primary_services_discover(m_conn_handle, SERVICE_CLIENT_START_HANDLE, &m_service_uuid));
-    m_service_client_state = SERVICE_CLIENT_STATE_CONNECTING;
-}
-
-
-uint32_t service_client_get_server_score(void)
-{
-    return m_server_score;
-}
-
-
-uint32_t service_client_get_current_time(void)
-{
-    return m_current_time;
-}
-
-
-uint32_t service_client_get_game_time(void)
-{
-    return m_game_time;
-}
-
-
-uint32_t service_client_get_vibration(void)
-{
-    return m_vibration;
-}
-
-
-uint32_t service_client_get_hole(void)
-{
-    return m_hole;
-}
-
-
-uint32_t service_client_get_target_score(void)
-{
-    return m_target_score;
-}
-
-
-void service_client_write_client_score(uint32_t score)
-{
-    service_client_write(BLE_GATT_OP_WRITE_REQ, m_info.client_score_handle, sizeof(score), &score);
-}
-
-
-static void service_client_write(uint8_t write_op, uint16_t handle, uint16_t len, void * p_value)
-{
-    if (0 == len)
-    {
-        return;
-    }
-
-    ble_gattc_write_params_t write_params;
-    memset(&write_params, 0, sizeof(write_params));
-
-    write_params.write_op   = write_op;
-    write_params.flags      = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE;
-    write_params.handle     = handle;
-    write_params.len        = len;
-    write_params.p_value    = (uint8_t *)p_value;
-
-    // Keep trying to send the message if it is busy.
-    uint32_t err_code = NRF_SUCCESS;
-    do
-    {
-        err_code = sd_ble_gattc_write(m_conn_handle, &write_params);
-    } while (NRF_ERROR_BUSY == err_code);
-    APP_ERROR_CHECK(err_code);
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall service_client.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall game client module.
+ */
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "ble_hci.h"
+#include "ble_srv_common.h"
+#include "ble_stack.h"
+#include "game.h"
+#include "log.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "service.h"
+#include "service_client.h"
+#include "sdk_common.h"
+#include "sync.h"
+
+static service_client_state_t  m_service_client_state;
+static ble_uuid_t           m_service_uuid = { SERVICE_BASE_UUID, BLE_UUID_TYPE_VENDOR_BEGIN };
+static uint16_t             m_service_handle;
+static uint16_t             m_conn_handle;
+static service_info_t       m_info = { 0 };
+static uint32_t             m_server_score;
+static service_current_time_t m_current_time;
+static uint32_t             m_game_time;
+static uint32_t             m_vibration;
+static uint32_t             m_hole;
+static uint32_t             m_target_score;
+static uint32_t             m_time;
+static service_bridge_t     m_bridge;
+
+
+void service_client_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    ble_gattc_evt_t * p_ble_gattc_evt = &p_ble_evt->evt.gattc_evt;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            memset(&m_bridge, 0, sizeof(m_bridge));
+            LOG1(LOG_CLIENT_CONNECTED, m_conn_handle);
+            break;
+        }
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            LOG1(LOG_CLIENT_DISCONNECTED, p_ble_evt->evt.gap_evt.params.disconnected.reason);
+            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            m_service_client_state = SERVICE_CLIENT_STATE_READY;
+            service_score_latency_lost();
+            if (m_bridge.is_active)
+            {
+                // Let the shell know that it is local again.
+                m_bridge.is_active = false;
+                scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+            }
+
+            break;
+        }
+        case BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP:
+        {
+            if (BLE_GATT_STATUS_SUCCESS == p_ble_gattc_evt->gatt_status)
+            {
+                // If we found it then save the handle and search again - to make sure we got the last one.
+                ble_gattc_evt_prim_srvc_disc_rsp_t * p_prim_srvc_disc_rsp = &p_ble_gattc_evt->params.prim_srvc_disc_rsp;
+                uint16_t count = p_prim_srvc_disc_rsp->count;
+                if (0 == count)
+                {
+                    return;
+                }
+
+                m_service_handle = p_prim_srvc_disc_rsp->services[count - 1].handle_range.start_handle;
+                sd_ble_gattc_primary_services_discover(m_conn_handle, m_service_handle + 1, &m_service_uuid);
+            }
+            else if (BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND == p_ble_gattc_evt->gatt_status)
+            {
+                // If we didn't find the service, but we found one previously then we are connected.
+                if (BLE_CONN_HANDLE_INVALID != m_service_handle)
+                {
+                    sd_ble_gattc_read(m_conn_handle, m_service_handle + SERVICE_INFO_ATTR_OFFSET, 0);
+                }
+                else
+                {
+                    // We never found the service so just go back to the SERVICE_CLIENT_STATE_READY state - connection failed.
+                    LOG0(LOG_CLIENT_SERVICE_NOT_FOUND);
+                    m_service_client_state = SERVICE_CLIENT_STATE_READY;
+                }
+            }
+
+            break;
+        }
+        case BLE_GATTC_EVT_READ_RSP:
+        {
+            // We got a response from the INFO characteristic, copy them into m_info.
+            ble_gattc_evt_read_rsp_t * p_read_rsp = &p_ble_gattc_evt->params.read_rsp;
+            if ((m_service_handle + SERVICE_INFO_ATTR_OFFSET) == p_read_rsp->handle)
+            {
+                memcpy(((uint8_t *)&m_info) + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
+
+                // Enable server score and game time indicate.
+                uint16_t write_value = BLE_GATT_HVX_INDICATION;
+                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.server_score_handle), sizeof(write_value), &write_value);
+                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.game_time_handle), sizeof(write_value), &write_value);
+                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.game_state_handle), sizeof(write_value), &write_value);
+                service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.current_time_handle), sizeof(write_value), &write_value);
+
+                sd_ble_gattc_read(m_conn_handle, m_info.game_time_handle, 0);
+            }
+            else if (m_info.game_time_handle == p_read_rsp->handle)
+            {
+                memcpy(&m_game_time + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
+                sd_ble_gattc_read(m_conn_handle, m_info.vibration_handle, 0);
+            }
+            else if (m_info.vibration_handle == p_read_rsp->handle)
+            {
+                memcpy(&m_vibration + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
+                sd_ble_gattc_read(m_conn_handle, m_info.hole_handle, 0);
+            }
+            else if (m_info.hole_handle == p_read_rsp->handle)
+            {
+                memcpy(&m_hole + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
+                sd_ble_gattc_read(m_conn_handle, m_info.target_score_handle, 0);
+            }
+            else if (m_info.target_score_handle == p_read_rsp->handle)
+            {
+                memcpy(&m_target_score + p_read_rsp->offset, p_read_rsp->data, p_read_rsp->len);
+                LOG3(LOG_CLIENT_SETTINGS, m_game_time, m_vibration, m_target_score);
+
+                // Everything is set up, so the clocks can be compared.
+                sync_start();
+            }
+
+            m_service_client_state = SERVICE_CLIENT_STATE_CONNECTED;
+            break;
+        }
+        case BLE_GATTC_EVT_WRITE_RSP:
+        {
+            if (m_info.client_score_handle == p_ble_gattc_evt->params.write_rsp.handle)
+            {
+                service_score_latency_stop();
+            }
+
+            break;
+        }
+        case BLE_GATTC_EVT_HVX:
+        {
+            ble_gattc_evt_hvx_t * p_hvx = &p_ble_gattc_evt->params.hvx;
+            if (p_hvx->handle == m_info.server_score_handle)
+            {
+                memcpy(&m_server_score, p_hvx->data, p_hvx->len);
+            }
+            else if (p_hvx->handle == m_info.game_time_handle)
+            {
+                memcpy(&m_time, p_hvx->data, p_hvx->len);
+            }
+            else if (p_hvx->handle == m_info.game_state_handle)
+            {
+                service_game_state_t game_state = { 0 };
+                memcpy(&game_state, p_hvx->data, MIN(p_hvx->len, sizeof(game_state)));
+                if ((GAME_STATE_INITIALIZING_GAME == game_state.state) &&
+                    (sizeof(game_state) == p_hvx->len) &&
+                    sync_is_synchronized())
+                {
+                    // Count down to the same moment as the server, rather than from when the indication got here.
+                    game_set_start_ticks(sync_peer_to_local_ticks(game_state.start_ticks));
+                }
+
+                game_set_state((game_state_t)game_state.state);
+            }
+            else if ((p_hvx->handle == m_info.current_time_handle) && (sizeof(m_current_time) == p_hvx->len))
+            {
+                memcpy(&m_current_time, p_hvx->data, sizeof(m_current_time));
+                sync_on_response(m_current_time.request_ticks,
+                                 m_current_time.receive_ticks,
+                                 m_current_time.response_ticks,
+                                 ble_stack_get_evt_ticks());
+            }
+            else if (p_hvx->handle == m_info.bridge_tx_handle)
+            {
+                // The server only sends what we have given it credits for, so this fits.
+                m_bridge.rx_received += p_hvx->len;
+                serial_write(p_hvx->data, p_hvx->len);
+                service_client_bridge_grant();
+            }
+            else if ((p_hvx->handle == m_info.bridge_credits_handle) && (sizeof(m_bridge.tx_limit) == p_hvx->len))
+            {
+                memcpy(&m_bridge.tx_limit, p_hvx->data, sizeof(m_bridge.tx_limit));
+                scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+            }
+
+            if (BLE_GATT_HVX_INDICATION == p_hvx->type)
+            {
+                // Send confirmation that we received the indicate message.
+                sd_ble_gattc_hv_confirm(m_conn_handle, p_hvx->handle);
+            }
+
+            break;
+        }
+        case BLE_EVT_TX_COMPLETE:
+        {
+            if (m_bridge.is_active)
+            {
+                // The SoftDevice has room for more, so the shell can send the rest of its input.
+                scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+            }
+
+            break;
+        }
+        case BLE_GATTC_EVT_TIMEOUT:
+        {
+            LOG1(LOG_CLIENT_TIMEOUT, p_ble_gattc_evt->params.timeout.src);
+            service_score_latency_lost();
+
+            // Something has timed out - Bluetooth Spec 4.1, Volume 3, Part F, Chapter 2 states
+            // that we must now break the connection.
+            APP_ERROR_CHECK(sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION));
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+void service_client_init(void)
+{
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+    m_service_client_state = SERVICE_CLIENT_STATE_INIT;
+}
+
+
+void service_client_tasks(void)
+{
+    switch (m_service_client_state)
+    {
+        case SERVICE_CLIENT_STATE_INIT:
+        {
+            m_service_client_state = SERVICE_CLIENT_STATE_READY;
+            break;
+        }
+        case SERVICE_CLIENT_STATE_READY:
+        {
+            break;
+        }
+        case SERVICE_CLIENT_STATE_CONNECTING:
+        {
+            break;
+        }
+        case SERVICE_CLIENT_STATE_CONNECTED:
+        {
+            break;
+        }
+        case SERVICE_CLIENT_STATE_ERROR:
+        {
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+bool service_client_is_connected(void)
+{
+    return m_service_client_state == SERVICE_CLIENT_STATE_CONNECTED;
+}
+
+
+void service_client_try_connect(void)
+{
+    if (BLE_CONN_HANDLE_INVALID == m_conn_handle)
+    {
+        return;
+    }
+
+    APP_ERROR_CHECK(sd_ble_gattc_primary_services_discover(m_conn_handle, SERVICE_CLIENT_START_HANDLE, &m_service_uuid));
+    m_service_client_state = SERVICE_CLIENT_STATE_CONNECTING;
+}
+
+
+uint32_t service_client_get_server_score(void)
+{
+    return m_server_score;
+}
+
+
+service_current_time_t const * service_client_get_current_time(void)
+{
+    return &m_current_time;
+}
+
+
+uint32_t service_client_get_game_time(void)
+{
+    return m_game_time;
+}
+
+
+uint32_t service_client_get_vibration(void)
+{
+    return m_vibration;
+}
+
+
+uint32_t service_client_get_hole(void)
+{
+    return m_hole;
+}
+
+
+uint32_t service_client_get_target_score(void)
+{
+    return m_target_score;
+}
+
+
+void service_client_write_client_score(uint32_t score)
+{
+    if (BLE_CONN_HANDLE_INVALID != m_conn_handle)
+    {
+        service_score_latency_start();
+    }
+
+    service_client_write(BLE_GATT_OP_WRITE_REQ, m_info.client_score_handle, sizeof(score), &score);
+}
+
+
+bool service_client_write_current_time(uint32_t request_ticks)
+{
+    if ((BLE_CONN_HANDLE_INVALID == m_conn_handle) || (0 == m_info.current_time_handle))
+    {
+        return false;
+    }
+
+    ble_gattc_write_params_t write_params;
+    memset(&write_params, 0, sizeof(write_params));
+    write_params.write_op   = BLE_GATT_OP_WRITE_REQ;
+    write_params.handle     = m_info.current_time_handle;
+    write_params.len        = sizeof(request_ticks);
+    write_params.p_value    = (uint8_t *)&request_ticks;
+
+    // A busy link only costs a sample, it isn't worth holding up the main loop for.
+    return NRF_SUCCESS == sd_ble_gattc_write(m_conn_handle, &write_params);
+}
+
+
+bool service_client_bridge_start(void)
+{
+    if ((BLE_CONN_HANDLE_INVALID == m_conn_handle) || (0 == m_info.bridge_tx_handle))
+    {
+        return false;
+    }
+
+    // Credits first, so that the server can send as soon as the notifications are on.
+    uint16_t write_value = BLE_GATT_HVX_NOTIFICATION;
+    service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.bridge_credits_handle), sizeof(write_value), &write_value);
+    m_bridge.is_active = true;
+    m_bridge.rx_granted = m_bridge.rx_received;
+    service_client_bridge_grant();
+    service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.bridge_tx_handle), sizeof(write_value), &write_value);
+    return true;
+}
+
+
+void service_client_bridge_stop(void)
+{
+    if (!m_bridge.is_active)
+    {
+        return;
+    }
+
+    uint16_t write_value = 0;
+    service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.bridge_tx_handle), sizeof(write_value), &write_value);
+    service_client_write(BLE_GATT_OP_WRITE_CMD, CONFIG_HANDLE(m_info.bridge_credits_handle), sizeof(write_value), &write_value);
+    m_bridge.is_active = false;
+}
+
+
+bool service_client_bridge_is_active(void)
+{
+    return m_bridge.is_active;
+}
+
+
+uint32_t service_client_bridge_write(uint8_t const * p_data, uint32_t size)
+{
+    uint32_t written = 0;
+    while (m_bridge.is_active && (written < size))
+    {
+        uint32_t credits = m_bridge.tx_limit - m_bridge.tx_sent;
+        if (0 == credits)
+        {
+            // The credits notification will bring the shell back.
+            m_bridge.stalls++;
+            break;
+        }
+
+        ble_gattc_write_params_t write_params;
+        memset(&write_params, 0, sizeof(write_params));
+        write_params.write_op   = BLE_GATT_OP_WRITE_CMD;
+        write_params.handle     = m_info.bridge_rx_handle;
+        write_params.len        = MIN(MIN(size - written, SERVICE_MAX_TX_BYTES), credits);
+        write_params.p_value    = (uint8_t *)&p_data[written];
+
+        uint32_t err_code = sd_ble_gattc_write(m_conn_handle, &write_params);
+        if (NRF_SUCCESS != err_code)
+        {
+            // Out of SoftDevice buffers, BLE_EVT_TX_COMPLETE will bring the shell back.
+            m_bridge.stalls++;
+            break;
+        }
+
+        written += write_params.len;
+        m_bridge.tx_sent += write_params.len;
+        m_bridge.tx_packets++;
+    }
+
+    return written;
+}
+
+
+void service_client_bridge_grant(void)
+{
+    if (!m_bridge.is_active)
+    {
+        return;
+    }
+
+    uint32_t limit = m_bridge.rx_received + serial_get_tx_room();
+    if (SERVICE_BRIDGE_CREDIT_STEP > (limit - m_bridge.rx_granted))
+    {
+        return;
+    }
+
+    ble_gattc_write_params_t write_params;
+    memset(&write_params, 0, sizeof(write_params));
+    write_params.write_op   = BLE_GATT_OP_WRITE_CMD;
+    write_params.handle     = m_info.bridge_credits_handle;
+    write_params.len        = sizeof(limit);
+    write_params.p_value    = (uint8_t *)&limit;
+
+    // If this doesn't go out it is tried again the next time the shell runs.
+    if (NRF_SUCCESS == sd_ble_gattc_write(m_conn_handle, &write_params))
+    {
+        m_bridge.rx_granted = limit;
+    }
+}
+
+
+service_bridge_t const * service_client_get_bridge(void)
+{
+    return &m_bridge;
+}
+
+
+static void service_client_write(uint8_t write_op, uint16_t handle, uint16_t len, void * p_value)
+{
+    if (0 == len)
+    {
+        return;
+    }
+
+    ble_gattc_write_params_t write_params;
+    memset(&write_params, 0, sizeof(write_params));
+
+    write_params.write_op   = write_op;
+    write_params.flags      = BLE_GATT_EXEC_WRITE_FLAG_PREPARED_WRITE;
+    write_params.handle     = handle;
+    write_params.len        = len;
+    write_params.p_value    = (uint8_t *)p_value;
+
+    // Keep trying to send the message if it is busy.
+    uint32_t err_code = NRF_SUCCESS;
+    do
+    {
+        err_code = sd_ble_gattc_write(m_conn_handle, &write_params);
+    } while (NRF_ERROR_BUSY == err_code);
+    APP_ERROR_CHECK(err_code);
+}
+
+/** @} */
@@ -1,479 +1,730 @@
-/**
- * @file
- * @defgroup WaterBall service_server.h
- * @{
- * @ingroup WaterBall
- * @brief WaterBall game server module.
- */
-
-#include "app_error.h"
-#include "app_util_platform.h"
-#include "ble_hci.h"
-#include "ble_srv_common.h"
-#include "service.h"
-#include "service_server.h"
-#include "sdk_common.h"
-
-#define NUM_CHARACTERISTICS     (sizeof(m_characteristics) / sizeof(m_characteristics[0]))
-
-static service_server_state_t   m_service_server_state;
-static uint16_t                 m_service_handle;
-static uint16_t                 m_conn_handle;
-static service_info_t           m_info = { 0 };
-static uint32_t                 m_server_score = 0;
-static uint32_t                 m_client_score = 0;
-static uint32_t                 m_current_time = 0;
-static uint32_t                 m_game_state = 0;
-static uint32_t                 m_game_time = 60000;
-static uint32_t                 m_vibration = 1;
-static uint32_t                 m_hole = UINT32_MAX;
-static uint32_t                 m_target_score = 0;
-
-static service_server_characteristic_t m_characteristics[] =
-{
-    { SERVICE_UUID(SERVICE_INFO_UUID),          sizeof(m_info),         service_server_read_info,           NULL,                               NULL,                           PROPERTY_READ },
-    { SERVICE_UUID(SERVICE_SERVER_SCORE_UUID),  sizeof(m_server_score), service_server_read_server_score,   NULL,                               &m_info.server_score_handle,    PROPERTY_READ | PROPERTY_INDICATE },
-    { SERVICE_UUID(SERVICE_CLIENT_SCORE_UUID),  sizeof(m_client_score), service_server_read_client_score,   service_server_write_client_score,  &m_info.client_score_handle,    PROPERTY_READ | PROPERTY_WRITE },
-    { SERVICE_UUID(SERVICE_GAME_STATE_UUID),    sizeof(m_game_state),   service_server_read_game_state,     NULL,                               &m_info.game_state_handle,      PROPERTY_READ | PROPERTY_INDICATE },
-    { SERVICE_UUID(SERVICE_CURRENT_TIME_UUID),  sizeof(m_current_time), service_server_read_current_time,   service_server_write_current_time,  &m_info.current_time_handle,    PROPERTY_READ | PROPERTY_WRITE | PROPERTY_INDICATE },
-    { SERVICE_UUID(SERVICE_GAME_TIME_UUID),     sizeof(m_game_time),    service_server_read_game_time,      service_server_write_game_time,     &m_info.game_time_handle,       PROPERTY_READ | PROPERTY_WRITE },
-    { SERVICE_UUID(SERVICE_VIBRATION_UUID),     sizeof(m_vibration),    service_server_read_vibration,      service_server_write_vibration,     &m_info.vibration_handle,       PROPERTY_READ | PROPERTY_WRITE },
-    { SERVICE_UUID(SERVICE_HOLE_UUID),          sizeof(m_hole),         service_server_read_hole,           service_server_write_hole,          &m_info.hole_handle,            PROPERTY_READ | PROPERTY_WRITE },
-    { SERVICE_UUID(SERVICE_TARGET_SCORE_UUID),  sizeof(m_target_score), service_server_read_target_score,   service_server_write_target_score,  &m_info.target_score_handle,    PROPERTY_READ | PROPERTY_WRITE },
-};
-
-
-void service_server_on_ble_evt(ble_evt_t * p_ble_evt)
-{
-    switch (p_ble_evt->header.evt_id)
-    {
-        case BLE_GAP_EVT_CONNECTED:
-        {
-            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
-            break;
-        }
-        case BLE_GAP_EVT_DISCONNECTED:
-        {
-            m_conn_handle = BLE_CONN_HANDLE_INVALID;
-            m_service_server_state = SERVICE_SERVER_STATE_READY;
-            break;
-        }
-        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
-        {
-            ble_gatts_evt_rw_authorize_request_t * auth = &p_ble_evt->evt.gatts_evt.params.authorize_request;
-            if (BLE_GATTS_AUTHORIZE_TYPE_READ == auth->type)
-            {
-                service_server_characteristic_t *  characteristic = service_server_get_characteristic(auth->request.read.uuid);
-                if ((NULL == characteristic) || (NULL == characteristic->read_callback))
-                {
-                    break;
-                }
-
-                characteristic->read_callback(p_ble_evt);
-            }
-
-            if (BLE_GATTS_AUTHORIZE_TYPE_WRITE == auth->type)
-            {
-                service_server_characteristic_t *  characteristic = service_server_get_characteristic(auth->request.write.uuid);
-                if ((NULL == characteristic) || (NULL == characteristic->write_callback))
-                {
-                    break;
-                }
-
-                characteristic->write_callback(p_ble_evt);
-            }
-
-            break;
-        }
-        case BLE_GATTS_EVT_SYS_ATTR_MISSING:
-        {
-            APP_ERROR_CHECK(sd_ble_gatts_sys_attr_set(m_conn_handle, NULL, 0, 0));
-            break;
-        }
-        case BLE_GATTS_EVT_HVC:
-        {
-            // A response was received from an indication.
-            break;
-        }
-        case BLE_GATTS_EVT_TIMEOUT:
-        {
-            // Something has timed out - Bluetooth Spec 4.1, Volume 3, Part F, Chapter 2 states
-            // that we must now break the connection.
-            APP_ERROR_CHECK(sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION));
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-void service_server_init(void)
-{
-    ble_uuid_t    service_uuid;
-    ble_uuid128_t base_uuid = SERVICE_BASE_UUID_128;
-
-    service_uuid.uuid = SERVICE_BASE_UUID;
-    APP_ERROR_CHECK(sd_ble_uuid_vs_add(&base_uuid, &service_uuid.type));
-
-    m_conn_handle = BLE_CONN_HANDLE_INVALID;
-
-    // Add the service.
-    APP_ERROR_CHECK(sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY,
-                                             &service_uuid,
-                                             &m_service_handle));
-
-    service_server_characteristic_t * characteristic = &m_characteristics[0];
-    for (int i = 0; i < NUM_CHARACTERISTICS; i++)
-    {
-        service_server_characteristic_add(characteristic++);
-    }
-
-    m_service_server_state = SERVICE_SERVER_STATE_INIT;
-}
-
-
-void service_server_tasks(void)
-{
-    static int cycle_count = 0;
-
-    switch (m_service_server_state)
-    {
-        case SERVICE_SERVER_STATE_INIT:
-        {
-            m_service_server_state = SERVICE_SERVER_STATE_READY;
-            break;
-        }
-        case SERVICE_SERVER_STATE_READY:
-        {
-            cycle_count = 0;
-            break;
-        }
-        case SERVICE_SERVER_STATE_CONNECTING:
-        {
-            // We don't want to get stuck in this state forever.
-            cycle_count++;
-            if (MAX_CONNECTING_CYCLES < cycle_count)
-            {
-                m_service_server_state = SERVICE_SERVER_STATE_READY;
-            }
-
-            break;
-        }
-        case SERVICE_SERVER_STATE_CONNECTED:
-        {
-            break;
-        }
-        case SERVICE_SERVER_STATE_ERROR:
-        {
-            break;
-        }
-        default:
-        {
-            break;
-        }
-    }
-}
-
-
-bool service_server_is_connected(void)
-{
-    return m_service_server_state == SERVICE_SERVER_STATE_CONNECTED;
-}
-
-
-static void service_server_hvx_send(uint8_t type, uint16_t handle, uint16_t len, void * p_value)
-{
-    uint32_t err_code;
-    if (m_conn_handle == BLE_CONN_HANDLE_INVALID)
-    {
-        return;
-    }
-
-    ble_gatts_hvx_params_t hvx_params;
-    memset(&hvx_params, 0, sizeof(hvx_params));
-    hvx_params.handle = handle;
-    hvx_params.type   = type;
-    hvx_params.p_len  = &len;
-    hvx_params.p_data = p_value;
-
-    do
-    {
-        err_code = sd_ble_gatts_hvx(m_conn_handle, &hvx_params);
-    } while (NRF_ERROR_BUSY == err_code);
-
-    if (NRF_ERROR_INVALID_STATE != err_code)
-    {
-        APP_ERROR_CHECK(err_code);
-    }
-}
-
-
-uint32_t service_server_get_client_score(void)
-{
-    return m_client_score;
-}
-
-
-uint32_t service_server_get_current_time(void)
-{
-    return m_current_time;
-}
-
-
-uint32_t service_server_get_game_time(void)
-{
-    return m_game_time;
-}
-
-
-uint32_t service_server_get_vibration(void)
-{
-    return m_vibration;
-}
-
-
-uint32_t service_server_get_hole(void)
-{
-    return m_hole;
-}
-
-
-uint32_t service_server_get_target_score(void)
-{
-    return m_target_score;
-}
-
-
-void service_server_indicate_server_score(uint32_t score)
-{
-    m_server_score = score;
-    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.server_score_handle, sizeof(m_server_score), &m_server_score);
-}
-
-
-void service_server_indicate_game_time(uint32_t ms_remaining)
-{
-    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.game_time_handle, sizeof(ms_remaining), &ms_remaining);
-}
-
-
-void service_server_indicate_game_state(uint32_t state)
-{
-    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.game_state_handle, sizeof(state), &state);
-}
-
-
-static void service_server_read_info(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_info), &m_info);
-    m_service_server_state = SERVICE_SERVER_STATE_CONNECTED;
-}
-
-
-static void service_server_read_server_score(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_server_score), &m_server_score);
-}
-
-
-static void service_server_read_client_score(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_client_score), &m_client_score);
-}
-
-
-static void service_server_read_game_time(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_game_time), &m_game_time);
-}
-
-
-static void service_server_read_vibration(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_vibration), &m_vibration);
-}
-
-
-static void service_server_read_hole(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_hole), &m_hole);
-}
-
-
-static void service_server_read_current_time(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_current_time), &m_current_time);
-}
-
-
-static void service_server_read_target_score(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_target_score), &m_target_score);
-}
-
-
-static void service_server_read_game_state(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
-    service_server_read_request_response(read->offset, sizeof(m_game_state), &m_game_state);
-}
-
-
-static void service_server_write_client_score(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_client_score = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_game_time(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_game_time = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_vibration(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_vibration = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_hole(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_hole = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_current_time(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_current_time = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_target_score(ble_evt_t * p_ble_evt)
-{
-    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
-    m_target_score = *(uint32_t *)write->data;
-    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
-}
-
-
-static void service_server_write_request_response(uint16_t gatt_status)
-{
-    ble_gatts_rw_authorize_reply_params_t reply;
-    memset(&reply, 0, sizeof(reply));
-
-    reply.type                      = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
-    reply.params.write.gatt_status  = gatt_status;
-    reply.params.write.update       = true;
-
-    APP_ERROR_CHECK(sd_ble_gatts_rw_authorize_reply(m_conn_handle, &reply));
-}
-
-
-static void service_server_read_request_response(uint16_t offset, uint16_t len, void * p_data)
-{
-    ble_gatts_rw_authorize_reply_params_t reply;
-    memset(&reply, 0, sizeof(reply));
-
-    reply.type                      = BLE_GATTS_AUTHORIZE_TYPE_READ;
-    reply.params.read.update        = true;
-    reply.params.read.gatt_status   = BLE_GATT_STATUS_SUCCESS;
-    reply.params.read.offset        = offset;
-    reply.params.read.p_data        = ((uint8_t *)p_data) + offset;
-    reply.params.read.len           = len - offset;
-
-    APP_ERROR_CHECK(sd_ble_gatts_rw_authorize_reply(m_conn_handle, &reply));
-}
-
-
-static void service_server_characteristic_add(service_server_characteristic_t * characteristic)
-{
-    // Add read/write properties to our characteristic.
-    ble_gatts_char_md_t char_md;
-    memset(&char_md, 0, sizeof(char_md));
-    char_md.char_props        = *((ble_gatt_char_props_t *)&characteristic->properties);
-
-    // Configure Client Characteristic Configuration Descriptor metadata and add to char_md structure.
-    if ((char_md.char_props.notify) || (char_md.char_props.indicate))
-    {
-        ble_gatts_attr_md_t cccd_md;
-        memset(&cccd_md, 0, sizeof(cccd_md));
-        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.read_perm);
-        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.write_perm);
-        cccd_md.vloc              = BLE_GATTS_VLOC_STACK;
-        char_md.p_cccd_md         = &cccd_md;
-    }
-
-    // Configure the attribute metadata.
-    ble_gatts_attr_md_t attr_md;
-    memset(&attr_md, 0, sizeof(attr_md));
-    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
-    attr_md.vlen    = true;
-    attr_md.rd_auth = true;
-    attr_md.wr_auth = true;
-
-    // Set read/write security levels to our characteristic.
-    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.write_perm);
-    if (char_md.char_props.read)
-    {
-        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
-    }
-
-    // Configure the characteristic value attribute.
-    ble_gatts_attr_t    attr_char_value;
-    memset(&attr_char_value, 0, sizeof(attr_char_value));
-    attr_char_value.p_uuid    = &characteristic->uuid;
-    attr_char_value.p_attr_md = &attr_md;
-    attr_char_value.max_len   = characteristic->max_length;
-
-    APP_ERROR_CHECK(sd_ble_gatts_characteristic_add(m_service_handle,
-                                                    &char_md,
-                                                    &attr_char_value,
-                                                    &characteristic->handles));
-
-    // Put the handles into our info table if we have a pointer.
-    if (NULL != characteristic->character_handle)
-    {
-        *characteristic->character_handle = characteristic->handles.value_handle;
-    }
-}
-
-
-static service_server_characteristic_t * service_server_get_characteristic(ble_uuid_t uuid)
-{
-    service_server_characteristic_t *  characteristic = &m_characteristics[0];
-    for (int i = 0; i < NUM_CHARACTERISTICS; i++)
-    {
-        if (characteristic->uuid.uuid == uuid.uuid)
-        {
-            return characteristic;
-        }
-
-        characteristic++;
-    }
-
-    return NULL;
-}
-
-/** @} */
+/**
+ * @file
+ * @defgroup WaterBall service_server.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall game server module.
+ */
+
+#include "app_error.h"
+#include "app_util_platform.h"
+#include "ble_hci.h"
+#include "ble_srv_common.h"
+#include "ble_stack.h"
+#include "clock.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "service.h"
+#include "service_server.h"
+#include "sdk_common.h"
+#include "sync.h"
+#include "timers.h"
+
+#define NUM_CHARACTERISTICS     (sizeof(m_characteristics) / sizeof(m_characteristics[0]))
+
+static service_server_state_t   m_service_server_state;
+static uint16_t                 m_service_handle;
+static uint16_t                 m_conn_handle;
+static service_info_t           m_info = { 0 };
+static uint32_t                 m_server_score = 0;
+static uint32_t                 m_client_score = 0;
+static service_current_time_t  m_current_time = { 0 };
+static service_game_state_t     m_game_state = { 0 };
+static uint32_t                 m_game_time = 60000;
+static uint32_t                 m_vibration = 1;
+static uint32_t                 m_hole = UINT32_MAX;
+static uint32_t                 m_target_score = 0;
+static profile_record_t         m_profile[SCHEDULER_MODULE_COUNT];
+static service_bridge_t         m_bridge;
+static timers_timer_t           m_connecting_timer;
+
+static service_server_characteristic_t m_characteristics[] =
+{
+    { SERVICE_UUID(SERVICE_INFO_UUID),          sizeof(m_info),         service_server_read_info,           NULL,                               NULL,                           PROPERTY_READ },
+    { SERVICE_UUID(SERVICE_SERVER_SCORE_UUID),  sizeof(m_server_score), service_server_read_server_score,   NULL,                               &m_info.server_score_handle,    PROPERTY_READ | PROPERTY_INDICATE },
+    { SERVICE_UUID(SERVICE_CLIENT_SCORE_UUID),  sizeof(m_client_score), service_server_read_client_score,   service_server_write_client_score,  &m_info.client_score_handle,    PROPERTY_READ | PROPERTY_WRITE },
+    { SERVICE_UUID(SERVICE_GAME_STATE_UUID),    sizeof(m_game_state),   service_server_read_game_state,     NULL,                               &m_info.game_state_handle,      PROPERTY_READ | PROPERTY_INDICATE },
+    { SERVICE_UUID(SERVICE_CURRENT_TIME_UUID),  sizeof(m_current_time), service_server_read_current_time,   service_server_write_current_time,  &m_info.current_time_handle,    PROPERTY_READ | PROPERTY_WRITE | PROPERTY_INDICATE },
+    { SERVICE_UUID(SERVICE_GAME_TIME_UUID),     sizeof(m_game_time),    service_server_read_game_time,      service_server_write_game_time,     &m_info.game_time_handle,       PROPERTY_READ | PROPERTY_WRITE },
+    { SERVICE_UUID(SERVICE_VIBRATION_UUID),     sizeof(m_vibration),    service_server_read_vibration,      service_server_write_vibration,     &m_info.vibration_handle,       PROPERTY_READ | PROPERTY_WRITE },
+    { SERVICE_UUID(SERVICE_HOLE_UUID),          sizeof(m_hole),         service_server_read_hole,           service_server_write_hole,          &m_info.hole_handle,            PROPERTY_READ | PROPERTY_WRITE },
+    { SERVICE_UUID(SERVICE_TARGET_SCORE_UUID),  sizeof(m_target_score), service_server_read_target_score,   service_server_write_target_score,  &m_info.target_score_handle,    PROPERTY_READ | PROPERTY_WRITE },
+    { SERVICE_UUID(SERVICE_PROFILE_UUID),       sizeof(m_profile),      service_server_read_profile,        NULL,                               NULL,                           PROPERTY_READ },
+    { SERVICE_UUID(SERVICE_BRIDGE_TX_UUID),     SERVICE_MAX_TX_BYTES,   NULL,                               NULL,                               &m_info.bridge_tx_handle,       PROPERTY_NOTIFY },
+    { SERVICE_UUID(SERVICE_BRIDGE_RX_UUID),     SERVICE_MAX_TX_BYTES,   NULL,                               service_server_write_bridge_rx,     &m_info.bridge_rx_handle,       PROPERTY_WRITE_WO_RESPONSE },
+    { SERVICE_UUID(SERVICE_BRIDGE_CREDITS_UUID), sizeof(uint32_t),      NULL,                               service_server_write_bridge_credits, &m_info.bridge_credits_handle, PROPERTY_WRITE_WO_RESPONSE | PROPERTY_NOTIFY },
+};
+
+
+void service_server_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    switch (p_ble_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            m_conn_handle = p_ble_evt->evt.gap_evt.conn_handle;
+            memset(&m_bridge, 0, sizeof(m_bridge));
+            break;
+        }
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            m_conn_handle = BLE_CONN_HANDLE_INVALID;
+            m_service_server_state = SERVICE_SERVER_STATE_READY;
+            service_score_latency_lost();
+            if (m_bridge.is_active)
+            {
+                m_bridge.is_active = false;
+                serial_set_tx_remote(false);
+            }
+
+            break;
+        }
+        case BLE_GATTS_EVT_WRITE:
+        {
+            // Writes without response aren't authorized, so the bridge writes and the CCCDs end up here.
+            ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.write;
+            if (CONFIG_HANDLE(m_info.bridge_tx_handle) == write->handle)
+            {
+                m_bridge.is_active = ble_srv_is_notification_enabled(write->data);
+                serial_set_tx_remote(m_bridge.is_active);
+            }
+
+            service_server_characteristic_t * characteristic = service_server_get_characteristic_by_handle(write->handle);
+            if ((NULL != characteristic) && (NULL != characteristic->write_callback))
+            {
+                characteristic->write_callback(p_ble_evt);
+            }
+
+            // The peer may have just turned on the credits notification.
+            scheduler_set_pending(SCHEDULER_MODULE_SERVICE);
+            break;
+        }
+        case BLE_EVT_TX_COMPLETE:
+        {
+            // The SoftDevice has room for more notifications.
+            service_server_bridge_send();
+            break;
+        }
+        case BLE_GATTS_EVT_RW_AUTHORIZE_REQUEST:
+        {
+            ble_gatts_evt_rw_authorize_request_t * auth = &p_ble_evt->evt.gatts_evt.params.authorize_request;
+            if (BLE_GATTS_AUTHORIZE_TYPE_READ == auth->type)
+            {
+                service_server_characteristic_t *  characteristic = service_server_get_characteristic(auth->request.read.uuid);
+                if ((NULL == characteristic) || (NULL == characteristic->read_callback))
+                {
+                    break;
+                }
+
+                characteristic->read_callback(p_ble_evt);
+            }
+
+            if (BLE_GATTS_AUTHORIZE_TYPE_WRITE == auth->type)
+            {
+                service_server_characteristic_t *  characteristic = service_server_get_characteristic(auth->request.write.uuid);
+                if ((NULL == characteristic) || (NULL == characteristic->write_callback))
+                {
+                    break;
+                }
+
+                characteristic->write_callback(p_ble_evt);
+            }
+
+            break;
+        }
+        case BLE_GATTS_EVT_SYS_ATTR_MISSING:
+        {
+            APP_ERROR_CHECK(sd_ble_gatts_sys_attr_set(m_conn_handle, NULL, 0, 0));
+            break;
+        }
+        case BLE_GATTS_EVT_HVC:
+        {
+            // A response was received from an indication.
+            if (m_info.server_score_handle == p_ble_evt->evt.gatts_evt.params.hvc.handle)
+            {
+                service_score_latency_stop();
+            }
+
+            break;
+        }
+        case BLE_GATTS_EVT_TIMEOUT:
+        {
+            service_score_latency_lost();
+
+            // Something has timed out - Bluetooth Spec 4.1, Volume 3, Part F, Chapter 2 states
+            // that we must now break the connection.
+            APP_ERROR_CHECK(sd_ble_gap_disconnect(m_conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION));
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+void service_server_init(void)
+{
+    ble_uuid_t    service_uuid;
+    ble_uuid128_t base_uuid = SERVICE_BASE_UUID_128;
+
+    service_uuid.uuid = SERVICE_BASE_UUID;
+    APP_ERROR_CHECK(sd_ble_uuid_vs_add(&base_uuid, &service_uuid.type));
+
+    m_conn_handle = BLE_CONN_HANDLE_INVALID;
+
+    // Add the service.
+    APP_ERROR_CHECK(sd_ble_gatts_service_add(BLE_GATTS_SRVC_TYPE_PRIMARY,
+                                             &service_uuid,
+                                             &m_service_handle));
+
+    service_server_characteristic_t * characteristic = &m_characteristics[0];
+    for (int i = 0; i < NUM_CHARACTERISTICS; i++)
+    {
+        service_server_characteristic_add(characteristic++);
+    }
+
+    timers_create(&m_connecting_timer, service_server_connecting_timeout_handler, NULL);
+    m_service_server_state = SERVICE_SERVER_STATE_INIT;
+}
+
+
+void service_server_tasks(void)
+{
+    switch (m_service_server_state)
+    {
+        case SERVICE_SERVER_STATE_INIT:
+        {
+            m_service_server_state = SERVICE_SERVER_STATE_READY;
+            break;
+        }
+        case SERVICE_SERVER_STATE_READY:
+        {
+            timers_stop(&m_connecting_timer);
+            break;
+        }
+        case SERVICE_SERVER_STATE_CONNECTING:
+        {
+            // We don't want to get stuck in this state forever.
+            if (!timers_is_running(&m_connecting_timer))
+            {
+                timers_start(&m_connecting_timer, SERVICE_CONNECTING_TIMEOUT_MS, 0);
+            }
+
+            break;
+        }
+        case SERVICE_SERVER_STATE_CONNECTED:
+        {
+            service_server_bridge_send();
+            service_server_bridge_grant();
+            break;
+        }
+        case SERVICE_SERVER_STATE_ERROR:
+        {
+            break;
+        }
+        default:
+        {
+            break;
+        }
+    }
+}
+
+
+bool service_server_is_connected(void)
+{
+    return m_service_server_state == SERVICE_SERVER_STATE_CONNECTED;
+}
+
+
+static void service_server_hvx_send(uint8_t type, uint16_t handle, uint16_t len, void * p_value)
+{
+    uint32_t err_code;
+    if (m_conn_handle == BLE_CONN_HANDLE_INVALID)
+    {
+        return;
+    }
+
+    ble_gatts_hvx_params_t hvx_params;
+    memset(&hvx_params, 0, sizeof(hvx_params));
+    hvx_params.handle = handle;
+    hvx_params.type   = type;
+    hvx_params.p_len  = &len;
+    hvx_params.p_data = p_value;
+
+    do
+    {
+        err_code = sd_ble_gatts_hvx(m_conn_handle, &hvx_params);
+    } while (NRF_ERROR_BUSY == err_code);
+
+    if (NRF_ERROR_INVALID_STATE != err_code)
+    {
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+
+service_bridge_t const * service_server_get_bridge(void)
+{
+    return &m_bridge;
+}
+
+
+uint32_t service_server_get_client_score(void)
+{
+    return m_client_score;
+}
+
+
+service_current_time_t const * service_server_get_current_time(void)
+{
+    return &m_current_time;
+}
+
+
+uint32_t service_server_get_game_time(void)
+{
+    return m_game_time;
+}
+
+
+uint32_t service_server_get_vibration(void)
+{
+    return m_vibration;
+}
+
+
+uint32_t service_server_get_hole(void)
+{
+    return m_hole;
+}
+
+
+uint32_t service_server_get_target_score(void)
+{
+    return m_target_score;
+}
+
+
+void service_server_set_game_time(uint32_t game_time)
+{
+    m_game_time = game_time;
+}
+
+
+void service_server_set_vibration(uint32_t vibration)
+{
+    m_vibration = vibration;
+}
+
+
+void service_server_set_hole(uint32_t hole)
+{
+    m_hole = hole;
+}
+
+
+void service_server_set_target_score(uint32_t target_score)
+{
+    m_target_score = target_score;
+}
+
+
+void service_server_indicate_server_score(uint32_t score)
+{
+    m_server_score = score;
+    if (BLE_CONN_HANDLE_INVALID != m_conn_handle)
+    {
+        service_score_latency_start();
+    }
+
+    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.server_score_handle, sizeof(m_server_score), &m_server_score);
+}
+
+
+void service_server_indicate_game_time(uint32_t ms_remaining)
+{
+    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.game_time_handle, sizeof(ms_remaining), &ms_remaining);
+}
+
+
+void service_server_indicate_game_state(uint32_t state, uint32_t start_ticks)
+{
+    m_game_state.state = state;
+    m_game_state.start_ticks = start_ticks;
+    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.game_state_handle, sizeof(m_game_state), &m_game_state);
+}
+
+
+static void service_server_read_info(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_info), &m_info);
+    m_service_server_state = SERVICE_SERVER_STATE_CONNECTED;
+}
+
+
+static void service_server_read_server_score(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_server_score), &m_server_score);
+}
+
+
+static void service_server_read_client_score(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_client_score), &m_client_score);
+}
+
+
+static void service_server_read_game_time(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_game_time), &m_game_time);
+}
+
+
+static void service_server_read_vibration(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_vibration), &m_vibration);
+}
+
+
+static void service_server_read_hole(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_hole), &m_hole);
+}
+
+
+static void service_server_read_current_time(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_current_time), &m_current_time);
+}
+
+
+static void service_server_read_target_score(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_target_score), &m_target_score);
+}
+
+
+static void service_server_read_game_state(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    service_server_read_request_response(read->offset, sizeof(m_game_state), &m_game_state);
+}
+
+
+static void service_server_read_profile(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_read_t * read = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.read;
+    if (0 == read->offset)
+    {
+        // Only take a new snapshot at the start of a long read, so all the pieces match.
+        profile_get_records(m_profile);
+    }
+
+    service_server_read_request_response(read->offset, sizeof(m_profile), m_profile);
+}
+
+
+static void service_server_write_client_score(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    m_client_score = *(uint32_t *)write->data;
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+}
+
+
+static void service_server_write_game_time(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    m_game_time = *(uint32_t *)write->data;
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+}
+
+
+static void service_server_write_vibration(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    m_vibration = *(uint32_t *)write->data;
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+}
+
+
+static void service_server_write_hole(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    m_hole = *(uint32_t *)write->data;
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+}
+
+
+static void service_server_write_current_time(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    if (sizeof(m_current_time.request_ticks) != write->len)
+    {
+        service_server_write_request_response(BLE_GATT_STATUS_ATTERR_INVALID_ATT_VAL_LENGTH);
+        return;
+    }
+
+    memcpy(&m_current_time.request_ticks, write->data, sizeof(m_current_time.request_ticks));
+    m_current_time.receive_ticks = ble_stack_get_evt_ticks();
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+
+    // Stamp the connection event the answer will go out in, the same way the client stamped its request.
+    m_current_time.response_ticks = sync_next_event_ticks((uint32_t)clock_get_ticks64());
+    service_server_hvx_send(BLE_GATT_HVX_INDICATION, m_info.current_time_handle, sizeof(m_current_time), &m_current_time);
+}
+
+
+static void service_server_write_target_score(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.authorize_request.request.write;
+    m_target_score = *(uint32_t *)write->data;
+    service_server_write_request_response(BLE_GATT_STATUS_SUCCESS);
+}
+
+
+static void service_server_write_bridge_rx(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.write;
+
+    // A peer that keeps to its credits always fits. Bytes that don't fit are only counted as
+    // dropped, so they use up the credits the peer took without being granted again.
+    uint32_t received = serial_receive(write->data, write->len);
+    m_bridge.rx_received += received;
+    m_bridge.rx_dropped += write->len - received;
+}
+
+
+static void service_server_write_bridge_credits(ble_evt_t * p_ble_evt)
+{
+    ble_gatts_evt_write_t * write = &p_ble_evt->evt.gatts_evt.params.write;
+    if (sizeof(m_bridge.tx_limit) == write->len)
+    {
+        memcpy(&m_bridge.tx_limit, write->data, sizeof(m_bridge.tx_limit));
+        service_server_bridge_send();
+    }
+}
+
+
+static void service_server_bridge_send(void)
+{
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    uint8_t packet[SERVICE_MAX_TX_BYTES];
+
+    while (m_bridge.is_active)
+    {
+        uint16_t len = MIN(serial_tx_peek(spans), sizeof(packet));
+        if (0 == len)
+        {
+            return;
+        }
+
+        uint32_t credits = m_bridge.tx_limit - m_bridge.tx_sent;
+        if (0 == credits)
+        {
+            // The credits characteristic will bring us back.
+            m_bridge.stalls++;
+            return;
+        }
+
+        // Fill the packet from both sides of the rollover.
+        len = MIN(len, credits);
+        uint16_t first_size = MIN(len, spans[0].size);
+        memcpy(packet, spans[0].p_data, first_size);
+        memcpy(&packet[first_size], spans[1].p_data, len - first_size);
+
+        ble_gatts_hvx_params_t hvx_params;
+        memset(&hvx_params, 0, sizeof(hvx_params));
+        hvx_params.handle = m_info.bridge_tx_handle;
+        hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+        hvx_params.p_len  = &len;
+        hvx_params.p_data = packet;
+
+        uint32_t err_code = sd_ble_gatts_hvx(m_conn_handle, &hvx_params);
+        if (BLE_ERROR_NO_TX_PACKETS == err_code)
+        {
+            // The SoftDevice buffers are full, BLE_EVT_TX_COMPLETE will bring us back.
+            m_bridge.stalls++;
+            return;
+        }
+
+        if (NRF_SUCCESS != err_code)
+        {
+            // Disconnected, or the peer turned the notifications off.
+            return;
+        }
+
+        serial_tx_consume(len);
+        m_bridge.tx_sent += len;
+        m_bridge.tx_packets++;
+    }
+}
+
+
+static void service_server_bridge_grant(void)
+{
+    if (!m_bridge.is_active)
+    {
+        return;
+    }
+
+    // The uart shares the receive buffer, so the limit can come out below the last grant.
+    uint32_t limit = m_bridge.rx_received + serial_get_rx_room();
+    if ((int32_t)SERVICE_BRIDGE_CREDIT_STEP > (int32_t)(limit - m_bridge.rx_granted))
+    {
+        return;
+    }
+
+    uint16_t len = sizeof(limit);
+    ble_gatts_hvx_params_t hvx_params;
+    memset(&hvx_params, 0, sizeof(hvx_params));
+    hvx_params.handle = m_info.bridge_credits_handle;
+    hvx_params.type   = BLE_GATT_HVX_NOTIFICATION;
+    hvx_params.p_len  = &len;
+    hvx_params.p_data = (uint8_t *)&limit;
+
+    // If this doesn't go out it is tried again the next time the receive buffer is read from.
+    if (NRF_SUCCESS == sd_ble_gatts_hvx(m_conn_handle, &hvx_params))
+    {
+        m_bridge.rx_granted = limit;
+    }
+}
+
+
+static void service_server_connecting_timeout_handler(void * p_context)
+{
+    if (SERVICE_SERVER_STATE_CONNECTING == m_service_server_state)
+    {
+        m_service_server_state = SERVICE_SERVER_STATE_READY;
+        scheduler_set_pending(SCHEDULER_MODULE_SERVICE);
+    }
+}
+
+
+static void service_server_write_request_response(uint16_t gatt_status)
+{
+    ble_gatts_rw_authorize_reply_params_t reply;
+    memset(&reply, 0, sizeof(reply));
+
+    reply.type                      = BLE_GATTS_AUTHORIZE_TYPE_WRITE;
+    reply.params.write.gatt_status  = gatt_status;
+    reply.params.write.update       = true;
+
+    APP_ERROR_CHECK(sd_ble_gatts_rw_authorize_reply(m_conn_handle, &reply));
+}
+
+
+static void service_server_read_request_response(uint16_t offset, uint16_t len, void * p_data)
+{
+    ble_gatts_rw_authorize_reply_params_t reply;
+    memset(&reply, 0, sizeof(reply));
+
+    reply.type                      = BLE_GATTS_AUTHORIZE_TYPE_READ;
+    reply.params.read.update        = true;
+    reply.params.read.gatt_status   = BLE_GATT_STATUS_SUCCESS;
+    reply.params.read.offset        = offset;
+    reply.params.read.p_data        = ((uint8_t *)p_data) + offset;
+    reply.params.read.len           = len - offset;
+
+    APP_ERROR_CHECK(sd_ble_gatts_rw_authorize_reply(m_conn_handle, &reply));
+}
+
+
+static void service_server_characteristic_add(service_server_characteristic_t * characteristic)
+{
+    // Add read/write properties to our characteristic.
+    ble_gatts_char_md_t char_md;
+    memset(&char_md, 0, sizeof(char_md));
+    char_md.char_props        = *((ble_gatt_char_props_t *)&characteristic->properties);
+
+    // Configure Client Characteristic Configuration Descriptor metadata and add to char_md structure.
+    if ((char_md.char_props.notify) || (char_md.char_props.indicate))
+    {
+        ble_gatts_attr_md_t cccd_md;
+        memset(&cccd_md, 0, sizeof(cccd_md));
+        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.read_perm);
+        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&cccd_md.write_perm);
+        cccd_md.vloc              = BLE_GATTS_VLOC_STACK;
+        char_md.p_cccd_md         = &cccd_md;
+    }
+
+    // Configure the attribute metadata.
+    ble_gatts_attr_md_t attr_md;
+    memset(&attr_md, 0, sizeof(attr_md));
+    attr_md.vloc    = BLE_GATTS_VLOC_STACK;
+    attr_md.vlen    = true;
+    attr_md.rd_auth = true;
+    attr_md.wr_auth = !char_md.char_props.write_wo_resp;    // A write command can't be answered.
+
+    // Set read/write security levels to our characteristic.
+    BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.write_perm);
+    if (char_md.char_props.read)
+    {
+        BLE_GAP_CONN_SEC_MODE_SET_OPEN(&attr_md.read_perm);
+    }
+
+    // Configure the characteristic value attribute.
+    ble_gatts_attr_t    attr_char_value;
+    memset(&attr_char_value, 0, sizeof(attr_char_value));
+    attr_char_value.p_uuid    = &characteristic->uuid;
+    attr_char_value.p_attr_md = &attr_md;
+    attr_char_value.max_len   = characteristic->max_length;
+
+    APP_ERROR_CHECK(sd_ble_gatts_characteristic_add(m_service_handle,
+                                                    &char_md,
+                                                    &attr_char_value,
+                                                    &characteristic->handles));
+
+    // Put the handles into our info table if we have a pointer.
+    if (NULL != characteristic->character_handle)
+    {
+        *characteristic->character_handle = characteristic->handles.value_handle;
+    }
+}
+
+
+static service_server_characteristic_t * service_server_get_characteristic(ble_uuid_t uuid)
+{
+    service_server_characteristic_t *  characteristic = &m_characteristics[0];
+    for (int i = 0; i < NUM_CHARACTERISTICS; i++)
+    {
+        if (characteristic->uuid.uuid == uuid.uuid)
+        {
+            return characteristic;
+        }
+
+        characteristic++;
+    }
+
+    return NULL;
+}
+
+
+static service_server_characteristic_t * service_server_get_characteristic_by_handle(uint16_t handle)
+{
+    service_server_characteristic_t *  characteristic = &m_characteristics[0];
+    for (int i = 0; i < NUM_CHARACTERISTICS; i++)
+    {
+        if (characteristic->handles.value_handle == handle)
+        {
+            return characteristic;
+        }
+
+        characteristic++;
+    }
+
+    return NULL;
+}
+
+/** @} */
@@ -1,9 +1,15 @@
 #include <string.h>
 
+#include "clock.h"
+#include "format.h"
 #include "i2c.h"
+#include "scheduler.h"
 #include "seven_segment.h"
 
-static set_value_t set_values[2] = { 0x00 };
+static set_value_t set_values[NUM_DISPLAYS] = { 0x00 };         // What is currently shown on the displays.
+static set_value_t frames[NUM_DISPLAYS] = { 0x00 };             // What should be shown on the displays at the next flush.
+static uint32_t    max_refresh_ms = SEVEN_SEGMENT_MAX_REFRESH_MS;
+static uint32_t    last_flush_ticks;
 
 static const uint8_t number_table[] =
 {
@@ -74,7 +80,7 @@ static const uint16_t alphafont_table[] =
     0x00, // *
     0x00, // +
     0x00, // ,
-    0x00, // -
+    0x40, // -
     0x00, // .
     0x00, // /
     0x3F, // 0
@@ -164,7 +170,8 @@ void seven_segment_init(void)
 {
     // Initialize the data to something or else it won't be able to clear it out.
     memset(set_values, 0xFF, sizeof(set_values));
-    
+    memset(frames, 0x00, sizeof(frames));
+
     i2c_byte_write(TIME_ADDRESS, HT16K33_OSC_ON);   
     i2c_byte_write(TIME_ADDRESS, HT16K33_DISPLAYON);
     i2c_byte_write(TIME_ADDRESS, HT16K33_DIM + 15);
@@ -174,45 +181,114 @@ void seven_segment_init(void)
     i2c_byte_write(SCORE_ADDRESS, HT16K33_DISPLAYON);
     i2c_byte_write(SCORE_ADDRESS, HT16K33_DIM + 15);
     seven_segment_blank_digits(SCORE_ADDRESS);
+
+    seven_segment_flush();
 }
 
 
 void seven_segment_tasks(void)
 {
+    if (!seven_segment_is_dirty())
+    {
+        scheduler_set_period(SCHEDULER_MODULE_SEVEN_SEGMENT, 0);
+        return;
+    }
+
+    if (!clock_ms_have_passed(last_flush_ticks, max_refresh_ms))
+    {
+        // Too soon, come back when the displays can be refreshed again.
+        scheduler_set_period(SCHEDULER_MODULE_SEVEN_SEGMENT, max_refresh_ms);
+        return;
+    }
+
+    seven_segment_flush();
+    scheduler_set_period(SCHEDULER_MODULE_SEVEN_SEGMENT, 0);
+}
+
+
+void seven_segment_set_max_refresh_rate(uint32_t ms)
+{
+    max_refresh_ms = ms;
+}
+
+
+void seven_segment_flush(void)
+{
+    last_flush_ticks = clock_get_ticks();
+
+    for (int i = 0; i < NUM_DISPLAYS; i++)
+    {
+        uint8_t address = HT16K33_BASE_ADDRESS + i;
+        set_value_t * p_frame = &frames[i];
+        set_value_t * p_shown = &set_values[i];
+
+        // Only send the displays that changed since the last flush.
+        if (0 != memcmp(p_frame, p_shown, sizeof(set_value_t)))
+        {
+            *p_shown = *p_frame;
+            seven_segment_write_frame(address, p_frame);
+        }
+    }
+}
+
+
+static bool seven_segment_is_dirty(void)
+{
+    return 0 != memcmp(frames, set_values, sizeof(frames));
 }
 
 
 static void seven_segment_set_digit_raw(uint8_t address, uint8_t digit, uint8_t data)
 {
     // Digits (L-to-R) are 0,1,2,3
-    // Send segment-data to specified digit (0-3) on led display
-    if (4 < digit)
+    if (3 < digit)
     {
         // Only digits 0-3
         return;
     }
 
-//    uint8_t address_index = address - HT16K33_BASE_ADDRESS;
-//    uint8_t * p_current_data = &set_values[address_index].digits[digit];
-//    if (*p_current_data == data)
-//    {
-//        // It is already set to this value, so don't worry about doing it again.
-//        return;
-//    }
+    uint8_t address_index = address - HT16K33_BASE_ADDRESS;
+    if (frames[address_index].digits[digit] == data)
+    {
+        // It is already set to this value, so don't worry about doing it again.
+        return;
+    }
+
+    frames[address_index].digits[digit] = data;
+    scheduler_set_pending(SCHEDULER_MODULE_SEVEN_SEGMENT);
+}
 
-//    *p_current_data = data;
 
-    // Skip over colon at position 2
-    if (1 < digit)
+static void seven_segment_write_frame(uint8_t address, set_value_t const * p_frame)
+{
+    // The display RAM address auto increments, so the whole image is sent in one transaction
+    // starting at address 0x00. Each row is two bytes and only the low byte is wired up, the
+    // digits are at rows 0, 1, 3 and 4, and the colon is at row 2.
+    // The colon is represented by bit 1 at address 0x04. There are three other
+    // single LED "decimal points" on the display, which are at the following bit positions
+    // bit2 = topo left, bit3=bottom left, bit4= top right
+    uint8_t tx_data[HT16K33_FRAME_SIZE + 1] =
     {
-        digit++;
-    }
+        0x00,
+        p_frame->digits[0], 0x00,
+        p_frame->digits[1], 0x00,
+        p_frame->colon,     0x00,
+        p_frame->digits[2], 0x00,
+        p_frame->digits[3], 0x00
+    };
+    (void)i2c_write(address, tx_data, sizeof(tx_data), seven_segment_write_frame_handler, NULL);
+}
 
-    // Multiply by 2
-    digit<<=1;
 
-    uint8_t tx_data[2] = {digit, data};
-    i2c_data_write(address, tx_data, sizeof(tx_data));
+static void seven_segment_write_frame_handler(uint8_t address, bool success, void * p_context)
+{
+    if (!success)
+    {
+        // The display didn't get the frame, so make sure it gets sent again at the next flush.
+        uint8_t address_index = address - HT16K33_BASE_ADDRESS;
+        memset(&set_values[address_index], 0xFF, sizeof(set_value_t));
+        scheduler_set_pending(SCHEDULER_MODULE_SEVEN_SEGMENT);
+    }
 }
 
 
@@ -251,26 +327,25 @@ static void seven_segment_set_char_digit(uint8_t address, uint8_t digit, char da
 static void seven_segment_set_colon(uint8_t address, colon_type_t colon_type)
 {
     uint8_t address_index = address - HT16K33_BASE_ADDRESS;
-    uint8_t * p_current_colon_type = &set_values[address_index].colon;
-    if (*p_current_colon_type == colon_type)
+    if (frames[address_index].colon == colon_type)
     {
         // It is already set to this value, so don't worry about doing it again.
         return;
     }
 
-    *p_current_colon_type = colon_type;
-
-    // The colon is represented by bit 1 at address 0x04. There are three other
-    // single LED "decimal points" on the display, which are at the following bit positions
-    // bit2 = topo left, bit3=bottom left, bit4= top right
-    uint8_t tx_data[] = { 0x04, colon_type };
-    i2c_data_write(address, tx_data, sizeof(tx_data));
+    frames[address_index].colon = colon_type;
+    scheduler_set_pending(SCHEDULER_MODULE_SEVEN_SEGMENT);
 }
 
 
-void seven_segment_set_numbers(uint8_t address, uint8_t left_value, uint8_t right_value, colon_type_t colon_type)
+
+void seven_segment_set_numbers(uint8_t address, uint32_t left_value, uint32_t right_value, colon_type_t colon_type)
 {
-    seven_segment_set_digits(address, left_value / 10, left_value % 10, right_value / 10, right_value % 10, colon_type);
+    // Values over 99 don't fit, they are shown as "--".
+    char digits[5];
+    format_score(&digits[0], left_value, 2);
+    format_score(&digits[2], right_value, 2);
+    seven_segment_set_char_digits(address, 0, digits, colon_type);
 }
 
 
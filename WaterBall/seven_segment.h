@@ -5,12 +5,16 @@
 #ifndef SEVEN_SEGMENT_H
 #define SEVEN_SEGMENT_H
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "app_twi.h"
 
 #define HT16K33_BASE_ADDRESS        0x70                            // I2C bus base address for Ht16K33 backpack
 #define TIME_ADDRESS                (HT16K33_BASE_ADDRESS + 0)
 #define SCORE_ADDRESS               (HT16K33_BASE_ADDRESS + 1)
+#define NUM_DISPLAYS                (2)
+
+#define SEVEN_SEGMENT_MAX_REFRESH_MS    (20)                        // Default for how often the displays can be refreshed.
 
 #define HT16K33_OSC_ON              0x21                            // turn device oscillator on
 #define HT16K33_STANDBY             0x20                            // turn device oscillator off
@@ -19,6 +23,7 @@
 #define HT16K33_BLINKON             0x85                            // blink rate 1 Hz (-2 for 2 Hz)
 #define HT16K33_BLINKOFF            0x81                            // same as display on
 #define HT16K33_DIM                 0xE0                            // add level (15=max) to byte
+#define HT16K33_FRAME_SIZE          10                              // display RAM bytes used by 4 digits and the colon
 
 // The bit numbers of each segment.
 //  0000
@@ -51,12 +56,27 @@ typedef struct
 // Initialize seven segment module(HT16K33).
 void seven_segment_init(void);
 
-// Tasks for the seven segment module.
+// Tasks for the seven segment module - flushes the frames to the displays.
 void seven_segment_tasks(void);
 
-// Setting raw digit.
+// Setting the shortest time between two refreshes of the displays.
+void seven_segment_set_max_refresh_rate(uint32_t ms);
+
+// Sending the frames that changed to both displays right now, one transaction per display.
+void seven_segment_flush(void);
+
+// Checking if the frames have changed since the last flush.
+static bool seven_segment_is_dirty(void);
+
+// Setting raw digit in the frame.
 static void seven_segment_set_digit_raw(uint8_t address, uint8_t digit, uint8_t data);
 
+// Sending a whole frame to the display RAM in one transaction.
+static void seven_segment_write_frame(uint8_t address, set_value_t const * p_frame);
+
+// Handling the end of a frame write, a frame that didn't make it is sent again.
+static void seven_segment_write_frame_handler(uint8_t address, bool success, void * p_context);
+
 // Clearing out digits.
 void seven_segment_blank_digit(uint8_t address, uint8_t digit);
 
@@ -66,11 +86,11 @@ static void seven_segment_set_digit(uint8_t address, uint8_t digit, uint8_t data
 // Setting actual led's of the seven segment display - given a character.
 static void seven_segment_set_char_digit(uint8_t address, uint8_t digit, char data);
 
-// Setting colon.
+// Setting colon in the frame.
 static void seven_segment_set_colon(uint8_t address, colon_type_t colon_type);
 
-// Setting the left and right 2 digit numbers.
-void seven_segment_set_numbers(uint8_t address, uint8_t left_value, uint8_t right_value, colon_type_t colon_type);
+// Setting the left and right 2 digit numbers, a number over 99 is shown as "--".
+void seven_segment_set_numbers(uint8_t address, uint32_t left_value, uint32_t right_value, colon_type_t colon_type);
 
 // Setting all seven segment all at once.
 void seven_segment_set_digits(uint8_t address, uint8_t digit_0, uint8_t digit_1, uint8_t digit_2, uint8_t digit_3, colon_type_t colon_type);
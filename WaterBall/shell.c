@@ -0,0 +1,413 @@
+/**
+ * @file
+ * @defgroup WaterBall shell.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall serial command shell module.
+ */
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_gap.h"
+#include "clock.h"
+#include "format.h"
+#include "game.h"
+#include "nordic_common.h"
+#include "profile.h"
+#include "scheduler.h"
+#include "service_client.h"
+#include "service_server.h"
+#include "shell.h"
+#include "status.h"
+#include "storage.h"
+#include "sync.h"
+#include "telemetry.h"
+#include "timers.h"
+
+static char                     m_line[SERIAL_RX_BUF_SIZE + 1];
+static char *                   m_argv[SHELL_MAX_ARGS];
+static uint32_t                 m_argc;
+static shell_command_t const *  mp_active_command;          /**< The command that is being continued, or NULL. */
+static uint32_t                 m_step;
+
+static shell_command_t const    m_commands[] =
+{
+    { "help",       "list the commands",                        shell_command_help      },
+    { "get",        "get <param> - read a game parameter",      shell_command_get       },
+    { "set",        "set <param> <value> - change a game parameter", shell_command_set  },
+    { "status",     "show the connection status and role",      shell_command_status    },
+    { "storage",    "dump the stored words",                    shell_command_storage   },
+    { "perf",       "perf [clear] - dump the profile of every module", shell_command_perf },
+    { "telemetry",  "telemetry [text|binary] - how the game reports", shell_command_telemetry },
+    { "baud",       "baud [rate] - change the rate, then confirm with baud at the new rate", shell_command_baud },
+    { "remote",     "use the shell of the connected peripheral, ctrl-] to return", shell_command_remote },
+    { "power",      "show the time asleep, the wakeups and the estimated current", shell_command_power },
+    { "sync",       "show the clock offset to the peer and how far apart the last game started", shell_command_sync }
+};
+
+static shell_param_t const      m_params[] =
+{
+    { "game_time",      service_server_get_game_time,       service_server_set_game_time    },
+    { "vibration",      service_server_get_vibration,       service_server_set_vibration    },
+    { "hole",           service_server_get_hole,            service_server_set_hole         },
+    { "target_score",   service_server_get_target_score,    service_server_set_target_score }
+};
+
+
+void shell_init(void)
+{
+    mp_active_command = NULL;
+    m_argc = 0;
+    m_step = 0;
+}
+
+
+void shell_tasks(void)
+{
+    serial_try_open();
+
+    if (service_client_bridge_is_active())
+    {
+        shell_remote_tasks();
+        return;
+    }
+
+    if (SHELL_LINE_SIZE > serial_get_tx_room())
+    {
+        // Wait for the last output to go out before writing more.
+        scheduler_set_period(SCHEDULER_MODULE_SHELL, SHELL_WAIT_PERIOD_MS);
+        return;
+    }
+
+    scheduler_set_period(SCHEDULER_MODULE_SHELL, 0);
+
+    if (NULL != mp_active_command)
+    {
+        if (!mp_active_command->handler(m_argc, m_argv, ++m_step))
+        {
+            mp_active_command = NULL;
+        }
+
+        // Come back to continue the command, or to read the next line.
+        scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+        return;
+    }
+
+    uint32_t size = serial_try_read_line((uint8_t *)m_line, sizeof(m_line) - 1);
+    if (0 == size)
+    {
+        return;
+    }
+
+    // There may be another line right behind this one.
+    scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+
+    m_line[size] = 0;
+    m_argc = shell_parse(m_line, m_argv);
+    if (0 == m_argc)
+    {
+        return;
+    }
+
+    for (int i = 0; i < ARRAY_SIZE(m_commands); i++)
+    {
+        if (0 == strcmp(m_argv[0], m_commands[i].p_name))
+        {
+            m_step = 0;
+            if (m_commands[i].handler(m_argc, m_argv, m_step))
+            {
+                mp_active_command = &m_commands[i];
+            }
+
+            return;
+        }
+    }
+
+    shell_printf("unknown command \"%s\", try help\r\n", m_argv[0]);
+}
+
+
+void shell_printf(char const * p_format, ...)
+{
+    static char buffer[SHELL_LINE_SIZE];
+
+    va_list args;
+    va_start(args, p_format);
+    uint32_t size = format_vstring(buffer, sizeof(buffer), p_format, args);
+    va_end(args);
+
+    if (0 < size)
+    {
+        serial_write((uint8_t *)buffer, size);
+    }
+}
+
+
+static void shell_remote_tasks(void)
+{
+    // Keep coming back to give the peripheral credits as the uart drains.
+    scheduler_set_period(SCHEDULER_MODULE_SHELL, SHELL_WAIT_PERIOD_MS);
+    service_client_bridge_grant();
+
+    serial_span_t spans[SERIAL_SPAN_COUNT];
+    serial_peek(spans);
+    for (int i = 0; i < SERIAL_SPAN_COUNT; i++)
+    {
+        uint8_t * p_escape = memchr(spans[i].p_data, SHELL_REMOTE_ESCAPE, spans[i].size);
+        uint32_t size = (NULL != p_escape) ? (p_escape - spans[i].p_data) : spans[i].size;
+
+        // Whatever doesn't go out stays in the receive buffer, and when that fills RTS goes high.
+        uint32_t sent = service_client_bridge_write(spans[i].p_data, size);
+        serial_consume(sent);
+        if (sent < size)
+        {
+            return;
+        }
+
+        if (NULL != p_escape)
+        {
+            serial_consume(1);
+            service_client_bridge_stop();
+            shell_printf("\r\nlocal shell\r\n");
+            scheduler_set_pending(SCHEDULER_MODULE_SHELL);
+            return;
+        }
+    }
+}
+
+
+static uint32_t shell_parse(char * p_line, char ** argv)
+{
+    uint32_t argc = 0;
+    char * p_word = strtok(p_line, " \t\r\n");
+    while ((NULL != p_word) && (argc < SHELL_MAX_ARGS))
+    {
+        argv[argc++] = p_word;
+        p_word = strtok(NULL, " \t\r\n");
+    }
+
+    return argc;
+}
+
+
+static shell_param_t const * shell_find_param(char const * p_name)
+{
+    for (int i = 0; i < ARRAY_SIZE(m_params); i++)
+    {
+        if (0 == strcmp(p_name, m_params[i].p_name))
+        {
+            return &m_params[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+static bool shell_command_help(uint32_t argc, char ** argv, uint32_t step)
+{
+    if (step < ARRAY_SIZE(m_commands))
+    {
+        shell_printf("%-8s %s\r\n", m_commands[step].p_name, m_commands[step].p_help);
+        return true;
+    }
+
+    // List the parameters on one line.
+    uint32_t param = step - ARRAY_SIZE(m_commands);
+    shell_printf("%s%s", (0 == param) ? "params: " : " ", m_params[param].p_name);
+    if ((param + 1) < ARRAY_SIZE(m_params))
+    {
+        return true;
+    }
+
+    shell_printf("\r\n");
+    return false;
+}
+
+
+static bool shell_command_get(uint32_t argc, char ** argv, uint32_t step)
+{
+    shell_param_t const * p_param = (2 <= argc) ? shell_find_param(argv[1]) : NULL;
+    if (NULL == p_param)
+    {
+        shell_printf("usage: get <param>, see help for the params\r\n");
+        return false;
+    }
+
+    shell_printf("%s %u\r\n", p_param->p_name, p_param->get());
+    return false;
+}
+
+
+static bool shell_command_set(uint32_t argc, char ** argv, uint32_t step)
+{
+    shell_param_t const * p_param = (3 <= argc) ? shell_find_param(argv[1]) : NULL;
+    char * p_end = NULL;
+    uint32_t value = (3 <= argc) ? strtoul(argv[2], &p_end, 0) : 0;
+    if ((NULL == p_param) || (NULL == p_end) || (0 != *p_end))
+    {
+        shell_printf("usage: set <param> <value>, see help for the params\r\n");
+        return false;
+    }
+
+    p_param->set(value);
+    shell_printf("%s %u\r\n", p_param->p_name, p_param->get());
+    return false;
+}
+
+
+static bool shell_command_status(uint32_t argc, char ** argv, uint32_t step)
+{
+    char const * p_role = IS_PERIPHERAL ? "peripheral" :
+                          IS_CENTRAL    ? "central" :
+                                          "invalid";
+    if (0 == step)
+    {
+        shell_printf("connected %u advertising %u discovering %u connecting %u role %s\r\n",
+                     IS_CONNECTED, IS_ADVERTISING, IS_DISCOVERING, IS_CONNECTING, p_role);
+        return true;
+    }
+
+    service_bridge_t const * p_bridge = IS_CENTRAL ? service_client_get_bridge() : service_server_get_bridge();
+    shell_printf("bridge active %u sent %u packets %u received %u dropped %u stalls %u\r\n",
+                 p_bridge->is_active, p_bridge->tx_sent, p_bridge->tx_packets,
+                 p_bridge->rx_received, p_bridge->rx_dropped, p_bridge->stalls);
+    return false;
+}
+
+
+static bool shell_command_storage(uint32_t argc, char ** argv, uint32_t step)
+{
+    if (0 == step)
+    {
+        shell_printf("storage ready %u\r\n", storage_is_ready());
+        return true;
+    }
+
+    storage_address_t address = (storage_address_t)(STORAGE_ADDRESS_MIN + step - 1);
+    shell_printf("%3d 0x%08x\r\n", address, *storage_memory_address(address));
+    return (address + 1) < STORAGE_ADDRESS_MAX;
+}
+
+
+static bool shell_command_perf(uint32_t argc, char ** argv, uint32_t step)
+{
+    if ((2 <= argc) && (0 == strcmp(argv[1], "clear")))
+    {
+        profile_clear();
+        shell_printf("perf cleared\r\n");
+        return false;
+    }
+
+    return profile_print_line(step);
+}
+
+
+static bool shell_command_baud(uint32_t argc, char ** argv, uint32_t step)
+{
+    if (2 <= argc)
+    {
+        char * p_end = NULL;
+        uint32_t baud = strtoul(argv[1], &p_end, 10);
+        if ((0 != *p_end) || !serial_request_baud(baud))
+        {
+            shell_printf("unsupported baud %s\r\n", argv[1]);
+            return false;
+        }
+
+        // This goes out at the old rate, then both sides switch.
+        shell_printf("baud %u ok, confirm within %u ms\r\n", baud, SERIAL_BAUD_CONFIRM_MS);
+        return false;
+    }
+
+    if (0 == step)
+    {
+        // Getting this line through means the current rate works.
+        serial_confirm_baud();
+
+        serial_error_counts_t const * p_errors = serial_get_error_counts();
+        shell_printf("baud %u overrun %u parity %u framing %u break %u rx full %u fallbacks %u\r\n",
+                     serial_get_baud(), p_errors->overrun, p_errors->parity, p_errors->framing,
+                     p_errors->break_condition, p_errors->rx_fifo_full, p_errors->baud_fallbacks);
+        return true;
+    }
+
+    shell_printf("high water rx %u of %u tx %u of %u\r\n",
+                 serial_get_rx_high_water(), SERIAL_RX_BUF_SIZE,
+                 serial_get_tx_high_water(), SERIAL_TX_BUF_SIZE);
+    return false;
+}
+
+
+static bool shell_command_remote(uint32_t argc, char ** argv, uint32_t step)
+{
+    if (!IS_CENTRAL || !service_client_bridge_start())
+    {
+        shell_printf("no peripheral with a serial bridge is connected\r\n");
+        return false;
+    }
+
+    shell_printf("remote shell, ctrl-] to return\r\n");
+    return false;
+}
+
+
+static bool shell_command_power(uint32_t argc, char ** argv, uint32_t step)
+{
+    uint64_t total_ticks = clock_get_ticks64();
+    uint32_t asleep_permille = (0 == total_ticks) ? 0 : (uint32_t)(scheduler_get_sleep_ticks() * 1000 / total_ticks);
+    shell_printf("uptime %u s asleep %u.%u%% wakeups %u latest %u us timers %u estimated %u uA\r\n",
+                 (uint32_t)(clock_get_us64() / 1000000),
+                 asleep_permille / 10, asleep_permille % 10,
+                 scheduler_get_wakeup_count(),
+                 (uint32_t)CLOCK_TICKS_IN_US(scheduler_get_max_wakeup_late_ticks()),
+                 timers_get_count(),
+                 scheduler_estimate_ua());
+    return false;
+}
+
+
+static bool shell_command_sync(uint32_t argc, char ** argv, uint32_t step)
+{
+    sync_stats_t const * p_sync = sync_get_stats();
+    if (0 == step)
+    {
+        shell_printf("sync %u offset %d ticks error %u us drift %d ppb rounds %u samples %u lost %u\r\n",
+                     p_sync->is_synchronized, (int32_t)p_sync->offset_ticks,
+                     (uint32_t)CLOCK_TICKS_IN_US(abs(p_sync->round_trip_ticks)) / 2,
+                     p_sync->drift_ppb, p_sync->rounds, p_sync->samples, p_sync->lost);
+        return true;
+    }
+
+    // The two sides start apart by the error of the offset, plus how late each of them was.
+    shell_printf("game start %u us late\r\n", game_get_start_late_us());
+    return false;
+}
+
+
+static bool shell_command_telemetry(uint32_t argc, char ** argv, uint32_t step)
+{
+    if (2 <= argc)
+    {
+        if (0 == strcmp(argv[1], "text"))
+        {
+            telemetry_set_mode(TELEMETRY_MODE_TEXT);
+        }
+        else if (0 == strcmp(argv[1], "binary"))
+        {
+            telemetry_set_mode(TELEMETRY_MODE_BINARY);
+        }
+        else
+        {
+            shell_printf("usage: telemetry [text|binary]\r\n");
+            return false;
+        }
+    }
+
+    shell_printf("telemetry %s\r\n", (TELEMETRY_MODE_BINARY == telemetry_get_mode()) ? "binary" : "text");
+    return false;
+}
+
+/** @} */
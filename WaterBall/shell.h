@@ -0,0 +1,123 @@
+/**
+ * @file
+ * @defgroup WaterBall shell.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall serial command shell module.
+ *
+ * Lines received on the serial port are split into words and looked up in a static
+ * command table. The words are split in place in the line buffer, nothing is allocated.
+ *
+ * At most one line is read, and at most one line of output is written, each time the
+ * shell runs. A command with more to say (perf, storage) is continued the next time,
+ * once the serial transmit ring has room for another line, so a long dump never holds
+ * up the main loop.
+ *
+ * On the central, "remote" hands the serial port to the shell of the peripheral over the
+ * BLE serial bridge. Everything typed goes to the peripheral until Ctrl-] is typed.
+ */
+
+#ifndef SHELL_H__
+#define SHELL_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "serial.h"
+
+#define SHELL_LINE_SIZE                 (128)       /**< The longest line that is written in one step. */
+#define SHELL_MAX_ARGS                  (4)         /**< The most words in a command, including the command itself. */
+#define SHELL_WAIT_PERIOD_MS            (10)        /**< How often to check for room in the transmit ring while a command is printing. */
+#define SHELL_REMOTE_ESCAPE             (0x1D)      /**< Ctrl-], like telnet, to get back to the local shell. */
+
+/**
+ * @brief   Function that runs a command.
+ *
+ * @param[in]   argc            The number of words in the command.
+ * @param[in]   argv            The words in the command, argv[0] is the command itself.
+ * @param[in]   step            0 the first time, then incremented every time the command is continued.
+ *
+ * @retval      True if the command has more to do and should be continued, false if it is done.
+ */
+typedef bool (* shell_command_handler_t)(uint32_t argc, char ** argv, uint32_t step);
+
+/**
+ * @brief   A command in the command table.
+ */
+typedef struct
+{
+    char const *                p_name;
+    char const *                p_help;
+    shell_command_handler_t     handler;
+} shell_command_t;
+
+/**
+ * @brief   A game parameter that can be read with "get" and changed with "set".
+ */
+typedef struct
+{
+    char const *                p_name;
+    uint32_t                    (* get)(void);
+    void                        (* set)(uint32_t value);
+} shell_param_t;
+
+/**
+ * @brief   Function to initialize the shell module.
+ */
+void shell_init(void);
+
+/**
+ * @brief   Function to accomplish the shell module tasks.
+ *
+ * @details This reads and runs one command, or continues the command that is running.
+ */
+void shell_tasks(void);
+
+/**
+ * @brief   Function to write a formatted line to the serial port.
+ *
+ * @details The line is cut short at SHELL_LINE_SIZE bytes.
+ *
+ * @param[in]   p_format        The printf style format, limited to what format_vstring understands.
+ */
+void shell_printf(char const * p_format, ...);
+
+/**
+ * @brief   Split a line into words, in place.
+ *
+ * @param[in]   p_line          The line, it must be zero terminated.
+ * @param[out]  argv            The words, it must have room for SHELL_MAX_ARGS words.
+ *
+ * @retval      The number of words.
+ */
+static uint32_t shell_parse(char * p_line, char ** argv);
+
+/**
+ * @brief   Send the serial input to the remote shell, up to the escape character.
+ */
+static void shell_remote_tasks(void);
+
+/**
+ * @brief   Find a game parameter by name.
+ *
+ * @param[in]   p_name          The name of the parameter.
+ *
+ * @retval      The parameter, or NULL if there is none by that name.
+ */
+static shell_param_t const * shell_find_param(char const * p_name);
+
+static bool shell_command_help(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_get(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_set(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_status(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_storage(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_perf(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_telemetry(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_baud(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_remote(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_power(uint32_t argc, char ** argv, uint32_t step);
+static bool shell_command_sync(uint32_t argc, char ** argv, uint32_t step);
+
+#endif //SHELL_H__
+
+/** @} */
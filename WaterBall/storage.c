@@ -11,6 +11,7 @@
 #include "app_error.h"
 #include "connect.h"
 #include "discovery.h"
+#include "log.h"
 #include "nordic_common.h"
 #include "pstorage.h"
 #include "status.h"
@@ -57,6 +58,7 @@ static void storage_event_handler(pstorage_handle_t *   p_handle,
 {
     if (NRF_SUCCESS != result)
     {
+        LOG2(LOG_STORAGE_ERROR, op_code, result);
         m_event_result = result;
         m_storage_state = STORAGE_STATE_ERROR;
     }
@@ -90,11 +92,13 @@ void storage_init(void)
             // If the checksum still doesn't match then our data is truly lost - or we are starting
             // for the first time. Clear it out just in case there is corrupt data.
             memset(m_flashed_copy, 0xFF, BLOCK_SIZE);
+            LOG0(LOG_STORAGE_CLEARED);
         }
         else
         {
             // If our data is good then make sure it gets copied into our flash page.
             storage_store_data(false);
+            LOG0(LOG_STORAGE_RESTORED_SWAP);
         }
     }
 
@@ -173,6 +177,7 @@ bool storage_update_value(storage_address_t address, uint32_t size, uint8_t * p_
     {
         // If it was locked we need to restore the original value.
         memcpy(p_local, p_volatile, size);
+        LOG1(LOG_STORAGE_LOCKED, address);
         return false;
     }
 
@@ -183,6 +188,7 @@ bool storage_update_value(storage_address_t address, uint32_t size, uint8_t * p_
     }
 
     memcpy(p_volatile, p_local, size);
+    LOG2(LOG_STORAGE_UPDATE, address, size);
 
     // Make sure auto_flash is true, or that we are setting auto_flash.
     if (m_auto_flash ||
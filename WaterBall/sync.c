@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @defgroup WaterBall sync.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall peer clock synchronization module.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_gap.h"
+#include "ble_stack.h"
+#include "clock.h"
+#include "game.h"
+#include "log.h"
+#include "service_client.h"
+#include "sync.h"
+#include "timers.h"
+
+static sync_stats_t         m_stats;
+static uint16_t             m_interval_units;           // The connection interval, in 1.25 ms units.
+static uint32_t             m_anchor_ticks;             // When the last packet arrived, which is on a connection event.
+static timers_timer_t       m_round_timer;
+static timers_timer_t       m_sample_timer;
+static uint32_t             m_sample_index;
+static bool                 m_is_waiting;               // True while the last request hasn't been answered.
+static uint32_t             m_request_ticks;
+static int32_t              m_best_round_trip_ticks;
+static uint32_t             m_best_offset_ticks;
+static uint32_t             m_best_mid_ticks;           // Halfway between T1 and T4 of the best sample, on our clock.
+static bool                 m_has_base;
+static uint32_t             m_base_offset_ticks;        // The offset of the first round of the connection, the drift is measured from it.
+static uint64_t             m_base_ticks;
+
+
+void sync_init(void)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+    m_interval_units = 0;
+    m_is_waiting = false;
+    m_has_base = false;
+    timers_create(&m_round_timer, sync_round_handler, NULL);
+    timers_create(&m_sample_timer, sync_sample_handler, NULL);
+}
+
+
+void sync_on_ble_evt(ble_evt_t * p_ble_evt)
+{
+    uint16_t evt_id = p_ble_evt->header.evt_id;
+    switch (evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            m_interval_units = p_ble_evt->evt.gap_evt.params.connected.conn_params.max_conn_interval;
+            m_anchor_ticks = ble_stack_get_evt_ticks();
+
+            // The peer may be a different device, so start over.
+            m_stats.is_synchronized = false;
+            m_stats.drift_ppb = 0;
+            m_has_base = false;
+            break;
+        }
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        {
+            m_interval_units = p_ble_evt->evt.gap_evt.params.conn_param_update.conn_params.max_conn_interval;
+            m_anchor_ticks = ble_stack_get_evt_ticks();
+            break;
+        }
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            timers_stop(&m_round_timer);
+            timers_stop(&m_sample_timer);
+            m_is_waiting = false;
+            m_stats.is_synchronized = false;
+            break;
+        }
+        default:
+        {
+            // Every GATT event and every sent packet comes from a connection event.
+            if (((BLE_GATTC_EVT_BASE <= evt_id) && (BLE_GATTS_EVT_LAST >= evt_id)) ||
+                (BLE_EVT_TX_COMPLETE == evt_id))
+            {
+                m_anchor_ticks = ble_stack_get_evt_ticks();
+            }
+
+            break;
+        }
+    }
+}
+
+
+void sync_start(void)
+{
+    timers_start(&m_round_timer, 0, SYNC_ROUND_PERIOD_MS);
+}
+
+
+uint32_t sync_next_event_ticks(uint32_t ticks)
+{
+    if (0 == m_interval_units)
+    {
+        return ticks;
+    }
+
+    // Count in hundredths of a tick, so the events stay on the grid however far from the anchor.
+    uint64_t interval_centiticks = (uint64_t)m_interval_units * SYNC_INTERVAL_UNIT_CENTITICKS;
+    uint64_t events = (((uint64_t)(ticks - m_anchor_ticks) * 100) / interval_centiticks) + 1;
+    return m_anchor_ticks + (uint32_t)((events * interval_centiticks) / 100);
+}
+
+
+void sync_on_response(uint32_t request_ticks, uint32_t receive_ticks, uint32_t response_ticks, uint32_t arrival_ticks)
+{
+    // Only the answer to the last request counts, the earlier ones were given up on.
+    if (!m_is_waiting || (request_ticks != m_request_ticks))
+    {
+        return;
+    }
+
+    m_is_waiting = false;
+    m_stats.samples++;
+
+    // Without a missed connection event this is only the difference in the interrupt
+    // latencies, so it can come out a little below zero.
+    int32_t round_trip_ticks = (int32_t)((arrival_ticks - request_ticks) - (response_ticks - receive_ticks));
+    if (abs(round_trip_ticks) < abs(m_best_round_trip_ticks))
+    {
+        m_best_round_trip_ticks = round_trip_ticks;
+        m_best_offset_ticks = (receive_ticks - request_ticks) - (round_trip_ticks / 2);
+        m_best_mid_ticks = request_ticks + ((arrival_ticks - request_ticks) / 2);
+    }
+}
+
+
+bool sync_is_synchronized(void)
+{
+    return m_stats.is_synchronized;
+}
+
+
+uint64_t sync_peer_to_local_ticks(uint32_t peer_ticks)
+{
+    uint64_t now_ticks = clock_get_ticks64();
+
+    // Place the time with the offset as it was measured, then again with the drift up to that time.
+    uint64_t local_ticks = now_ticks + (int32_t)(peer_ticks - m_stats.offset_ticks - (uint32_t)now_ticks);
+    return now_ticks + (int32_t)(peer_ticks - sync_offset_at(local_ticks) - (uint32_t)now_ticks);
+}
+
+
+sync_stats_t const * sync_get_stats(void)
+{
+    return &m_stats;
+}
+
+
+static void sync_round_handler(void * p_context)
+{
+    if (game_is_playing())
+    {
+        // The score writes would have to wait behind the requests, so leave the link to the game.
+        return;
+    }
+
+    m_sample_index = 0;
+    m_best_round_trip_ticks = INT32_MAX;
+    timers_start(&m_sample_timer, 0, SYNC_SAMPLE_PERIOD_MS);
+}
+
+
+static void sync_sample_handler(void * p_context)
+{
+    if (m_is_waiting)
+    {
+        // The next request takes its place.
+        m_is_waiting = false;
+        m_stats.lost++;
+    }
+
+    if (SYNC_SAMPLE_COUNT <= m_sample_index)
+    {
+        timers_stop(&m_sample_timer);
+        sync_end_round();
+        return;
+    }
+
+    m_sample_index++;
+
+    // Stamp the connection event the request will go out in, the server does the same with its answer.
+    m_request_ticks = sync_next_event_ticks((uint32_t)clock_get_ticks64());
+    if (service_client_write_current_time(m_request_ticks))
+    {
+        m_is_waiting = true;
+    }
+    else
+    {
+        m_stats.lost++;
+    }
+}
+
+
+static void sync_end_round(void)
+{
+    if (INT32_MAX == m_best_round_trip_ticks)
+    {
+        // Nothing came back, so keep the last estimate.
+        return;
+    }
+
+    uint64_t now_ticks = clock_get_ticks64();
+    uint64_t reference_ticks = now_ticks - (uint32_t)((uint32_t)now_ticks - m_best_mid_ticks);
+    if (!m_has_base)
+    {
+        m_base_offset_ticks = m_best_offset_ticks;
+        m_base_ticks = reference_ticks;
+        m_has_base = true;
+    }
+    else if ((reference_ticks - m_base_ticks) >= CLOCK_MS_IN_TICKS(SYNC_MIN_DRIFT_SPAN_MS))
+    {
+        // The error of the two offsets is spread over the whole connection, so the drift gets
+        // better the longer it lasts.
+        int64_t drift_ppb = ((int64_t)(int32_t)(m_best_offset_ticks - m_base_offset_ticks) * 1000000000) /
+                            (int64_t)(reference_ticks - m_base_ticks);
+        if ((-SYNC_MAX_DRIFT_PPB <= drift_ppb) && (SYNC_MAX_DRIFT_PPB >= drift_ppb))
+        {
+            m_stats.drift_ppb = (int32_t)drift_ppb;
+        }
+    }
+
+    m_stats.offset_ticks = m_best_offset_ticks;
+    m_stats.reference_ticks = reference_ticks;
+    m_stats.round_trip_ticks = m_best_round_trip_ticks;
+    m_stats.is_synchronized = true;
+    m_stats.rounds++;
+    LOG3(LOG_SYNC_ROUND, (int32_t)m_stats.offset_ticks, m_stats.round_trip_ticks, m_stats.drift_ppb);
+}
+
+
+static uint32_t sync_offset_at(uint64_t ticks)
+{
+    int64_t elapsed_ticks = (int64_t)(ticks - m_stats.reference_ticks);
+    return m_stats.offset_ticks + (int32_t)((elapsed_ticks * m_stats.drift_ppb) / 1000000000);
+}
+
+
+/** @} */
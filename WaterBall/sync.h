@@ -0,0 +1,158 @@
+/**
+ * @file
+ * @defgroup WaterBall sync.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall peer clock synchronization module.
+ *
+ * The client estimates the offset between its 64 bit clock and the one on the server, so
+ * that both can act at the same moment, like the end of the game count down. It is an NTP
+ * style exchange over the current time characteristic: the client writes its time T1,
+ * the server notes the time the write arrived T2 and indicates T1, T2 and the time of its
+ * answer T3, and the client notes the time the indication arrived T4. Then
+ *
+ *     offset = ((T2 - T1) + (T3 - T4)) / 2
+ *     round trip = (T4 - T1) - (T3 - T2)
+ *
+ * and the offset is out by half of the difference between the two directions, which is
+ * at most half of the round trip.
+ *
+ * Over BLE the two directions aren't alike. A packet waits for the next connection event,
+ * anything up to a whole connection interval, so each side stamps the connection event
+ * its packet will go out in rather than the moment it hands it to the SoftDevice. The
+ * connection events are one interval apart from the last packet that was received, and
+ * the received packets are timed in the SoftDevice event interrupt, so both directions are
+ * timed the same way again. A packet that misses its connection event adds an interval to
+ * the round trip, so each round takes SYNC_SAMPLE_COUNT samples and keeps the one with the
+ * shortest round trip.
+ *
+ * The rounds repeat every SYNC_ROUND_PERIOD_MS while the client is connected. The change
+ * in the offset since the first round of the connection gives the drift between the two
+ * 32 kHz crystals, so a time can still be converted long after the last round.
+ *
+ * All of the times that go over the air are the low 32 bits of the 64 bit clocks, they
+ * are compared with wrapping arithmetic like the 32 bit ticks.
+ */
+
+#ifndef SYNC_H__
+#define SYNC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble.h"
+
+#define SYNC_SAMPLE_COUNT                   (16)
+#define SYNC_SAMPLE_PERIOD_MS               (50)        /**< Time for the write and the indication to make it through at the longest connection interval. */
+#define SYNC_ROUND_PERIOD_MS                (10000)
+#define SYNC_MIN_DRIFT_SPAN_MS              (30000)     /**< Each offset is only good to a few ticks, so the drift is measured over at least this long. */
+#define SYNC_MAX_DRIFT_PPB                  (200000)    /**< Far more than two 32 kHz crystals can drift apart, anything faster is a bad round. */
+#define SYNC_INTERVAL_UNIT_CENTITICKS       (125 * APP_TIMER_CLOCK_FREQ / (((APP_TIMER_PRESCALER) + 1) * 1000))   /**< A connection interval unit is 1.25 ms, 40.96 ticks. */
+
+/**
+ * @brief   The estimate of the peer clock.
+ */
+typedef struct
+{
+    bool        is_synchronized;        /**< True once a round has finished on this connection. */
+    uint32_t    offset_ticks;           /**< The peer clock minus ours, at reference_ticks, wrapping with the clocks, so read it as an int32_t. */
+    uint64_t    reference_ticks;        /**< When the offset was measured, on our 64 bit clock. */
+    int32_t     round_trip_ticks;       /**< The round trip of the sample the offset came from. */
+    int32_t     drift_ppb;              /**< How fast the peer clock gains on ours, in parts per billion. */
+    uint32_t    rounds;
+    uint32_t    samples;                /**< The samples that came back. */
+    uint32_t    lost;                   /**< The samples that couldn't be sent or didn't come back in time. */
+} sync_stats_t;
+
+/**
+ * @brief   Function to initialize the sync module.
+ */
+void sync_init(void);
+
+/**
+ * @brief   Function called on ble events, to follow the connection events.
+ *
+ * @param[in]   p_ble_evt       The event data.
+ */
+void sync_on_ble_evt(ble_evt_t * p_ble_evt);
+
+/**
+ * @brief   Start the rounds, once the client has found the current time characteristic.
+ */
+void sync_start(void);
+
+/**
+ * @brief   Find the connection event that a packet handed to the SoftDevice now will go out in.
+ *
+ * @param[in]   ticks           The time now, the low 32 bits of the 64 bit clock.
+ *
+ * @retval      The time of the next connection event, as the peer will time the packet.
+ */
+uint32_t sync_next_event_ticks(uint32_t ticks);
+
+/**
+ * @brief   Add a sample when the answer of the server arrives.
+ *
+ * @param[in]   request_ticks   T1, when the request went out on our clock.
+ * @param[in]   receive_ticks   T2, when the request arrived on the server clock.
+ * @param[in]   response_ticks  T3, when the answer went out on the server clock.
+ * @param[in]   arrival_ticks   T4, when the answer arrived on our clock.
+ */
+void sync_on_response(uint32_t request_ticks, uint32_t receive_ticks, uint32_t response_ticks, uint32_t arrival_ticks);
+
+/**
+ * @brief   Test to see if the peer clock is known.
+ *
+ * @retval      True if a round has finished on this connection.
+ */
+bool sync_is_synchronized(void);
+
+/**
+ * @brief   Convert a time on the peer clock to ours.
+ *
+ * @details The time must be within about 18 hours of now, so that the low 32 bits place it.
+ *
+ * @param[in]   peer_ticks      The low 32 bits of the 64 bit clock of the peer.
+ *
+ * @retval      The same moment on our 64 bit clock.
+ */
+uint64_t sync_peer_to_local_ticks(uint32_t peer_ticks);
+
+/**
+ * @brief   Get the estimate of the peer clock.
+ *
+ * @retval      A pointer to the estimate and its statistics.
+ */
+sync_stats_t const * sync_get_stats(void);
+
+/**
+ * @brief   Start a round of samples.
+ *
+ * @param[in]   p_context       Not used.
+ */
+static void sync_round_handler(void * p_context);
+
+/**
+ * @brief   Send the next sample of a round, or finish the round.
+ *
+ * @param[in]   p_context       Not used.
+ */
+static void sync_sample_handler(void * p_context);
+
+/**
+ * @brief   Take the best sample of the round as the new offset, and update the drift.
+ */
+static void sync_end_round(void);
+
+/**
+ * @brief   Get the offset at a time, allowing for the drift since it was measured.
+ *
+ * @param[in]   ticks           The time on our 64 bit clock.
+ *
+ * @retval      The peer clock minus ours at that time.
+ */
+static uint32_t sync_offset_at(uint64_t ticks);
+
+#endif //SYNC_H__
+
+/** @} */
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @defgroup WaterBall telemetry.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall binary telemetry module.
+ */
+
+#include "app_util.h"
+#include "clock.h"
+#include "crc16.h"
+#include "nordic_common.h"
+#include "scheduler.h"
+#include "serial.h"
+#include "service.h"
+#include "status.h"
+#include "telemetry.h"
+
+static telemetry_mode_t         m_mode = TELEMETRY_MODE_TEXT;
+
+
+void telemetry_set_mode(telemetry_mode_t mode)
+{
+    m_mode = mode;
+
+    // The log is only sent in binary mode, so let it know.
+    scheduler_set_pending(SCHEDULER_MODULE_LOG);
+}
+
+
+telemetry_mode_t telemetry_get_mode(void)
+{
+    return m_mode;
+}
+
+
+void telemetry_send_game(uint8_t state, uint32_t my_score, uint32_t their_score, uint32_t ms_remaining)
+{
+    static uint8_t record[TELEMETRY_GAME_RECORD_SIZE + TELEMETRY_CRC_SIZE];
+
+    if (TELEMETRY_MODE_BINARY != m_mode)
+    {
+        return;
+    }
+
+    service_latency_t const * p_latency = service_get_score_latency();
+    uint32_t latency_avg_ms = (0 == p_latency->count) ? 0 : CLOCK_TICKS_IN_MS(p_latency->total_ticks / p_latency->count);
+
+    uint8_t * p_record = record;
+    *p_record++ = TELEMETRY_RECORD_GAME;
+    p_record += uint32_encode(clock_get_ticks(), p_record);
+    *p_record++ = state;
+    p_record += uint16_encode(MIN(my_score, UINT16_MAX), p_record);
+    p_record += uint16_encode(MIN(their_score, UINT16_MAX), p_record);
+    p_record += uint32_encode(ms_remaining, p_record);
+    *p_record++ = IS_CONNECTED;
+    p_record += uint16_encode(MIN(latency_avg_ms, UINT16_MAX), p_record);
+    p_record += uint16_encode(MIN(p_latency->lost, UINT16_MAX), p_record);
+
+    telemetry_send_record(record, TELEMETRY_GAME_RECORD_SIZE);
+}
+
+
+void telemetry_send_record(uint8_t * p_record, uint32_t size)
+{
+    static uint8_t frame[TELEMETRY_MAX_FRAME_SIZE];
+
+    uint16_t crc = crc16_compute(p_record, size, NULL);
+    size += uint16_encode(crc, &p_record[size]);
+
+    // Start with a zero as well, so that a record right after any text on the serial port still decodes.
+    frame[0] = 0x00;
+    uint32_t frame_size = telemetry_cobs_encode(p_record, size, &frame[1]) + 1;
+    frame[frame_size++] = 0x00;
+    serial_write(frame, frame_size);
+}
+
+
+static uint32_t telemetry_cobs_encode(uint8_t const * p_in, uint32_t size, uint8_t * p_out)
+{
+    // Every zero is replaced by the distance to the next zero, and one more distance is put
+    // at the front to point at the first one.
+    uint32_t code_i = 0;
+    uint32_t out_i = 1;
+    uint8_t code = 1;
+
+    for (uint32_t in_i = 0; in_i < size; in_i++)
+    {
+        if (0 == p_in[in_i])
+        {
+            p_out[code_i] = code;
+            code_i = out_i++;
+            code = 1;
+        }
+        else
+        {
+            p_out[out_i++] = p_in[in_i];
+            code++;
+        }
+    }
+
+    p_out[code_i] = code;
+    return out_i;
+}
+
+/** @} */
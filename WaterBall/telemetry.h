@@ -0,0 +1,85 @@
+/**
+ * @file
+ * @defgroup WaterBall telemetry.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall binary telemetry module.
+ *
+ * In binary mode the game sends fixed layout records over the serial port instead of
+ * formatting text. Every record is followed by a CRC16 (CCITT, from the SDK crc16 module)
+ * and the whole thing is COBS encoded with a zero byte on either side, so a reader can
+ * always find the start of the next record. Tools/Telemetry/telemetry_decode.py turns the stream
+ * into CSV.
+ *
+ * All of the fields are little endian.
+ */
+
+#ifndef TELEMETRY_H__
+#define TELEMETRY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TELEMETRY_RECORD_GAME           (0x01)      /**< The record type of a game record. */
+#define TELEMETRY_RECORD_LOG            (0x02)      /**< The record type of a log message, see log.h. */
+#define TELEMETRY_GAME_RECORD_SIZE      (19)        /**< type(1) ticks(4) state(1) my score(2) their score(2) ms remaining(4) connected(1) latency avg ms(2) latency lost(2) */
+#define TELEMETRY_LOG_RECORD_SIZE(ARGC) (6 + (4 * (ARGC)))  /**< type(1) id(1) ticks(4) args(4 each) */
+#define TELEMETRY_CRC_SIZE              (2)
+#define TELEMETRY_MAX_RECORD_SIZE       (TELEMETRY_GAME_RECORD_SIZE)
+#define TELEMETRY_MAX_FRAME_SIZE        (TELEMETRY_MAX_RECORD_SIZE + TELEMETRY_CRC_SIZE + 3)   /**< COBS adds one byte for up to 254 bytes, plus a zero at each end. */
+
+/**
+ * @brief   How the game reports on the serial port.
+ */
+typedef enum
+{
+    TELEMETRY_MODE_TEXT,                /**< Human readable text. */
+    TELEMETRY_MODE_BINARY               /**< COBS framed binary records. */
+} telemetry_mode_t;
+
+/**
+ * @brief   Set how the game reports on the serial port.
+ *
+ * @param[in]   mode            The new mode.
+ */
+void telemetry_set_mode(telemetry_mode_t mode);
+
+/**
+ * @brief   Get how the game reports on the serial port.
+ *
+ * @retval      The current mode.
+ */
+telemetry_mode_t telemetry_get_mode(void);
+
+/**
+ * @brief   Send a game record, if in binary mode.
+ *
+ * @param[in]   state           The game state.
+ * @param[in]   my_score        Our score, saturated at 16 bits.
+ * @param[in]   their_score     Their score, saturated at 16 bits.
+ * @param[in]   ms_remaining    The time left in the game.
+ */
+void telemetry_send_game(uint8_t state, uint32_t my_score, uint32_t their_score, uint32_t ms_remaining);
+
+/**
+ * @brief   Add the CRC, COBS encode a record and send it.
+ *
+ * @param[in]   p_record        The record, starting with its type. It must have room for the CRC after it.
+ * @param[in]   size            The size of the record without the CRC, at most TELEMETRY_MAX_RECORD_SIZE.
+ */
+void telemetry_send_record(uint8_t * p_record, uint32_t size);
+
+/**
+ * @brief   COBS encode a buffer.
+ *
+ * @param[in]   p_in            The bytes to encode, at most 254 of them.
+ * @param[in]   size            The number of bytes to encode.
+ * @param[out]  p_out           The encoded bytes, it must have room for size + 1 bytes.
+ *
+ * @retval      The number of encoded bytes.
+ */
+static uint32_t telemetry_cobs_encode(uint8_t const * p_in, uint32_t size, uint8_t * p_out);
+
+#endif //TELEMETRY_H__
+
+/** @} */
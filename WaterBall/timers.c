@@ -0,0 +1,233 @@
+/**
+ * @file
+ * @defgroup WaterBall timers.c
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall software timers module.
+ */
+
+#include <string.h>
+
+#include "app_util.h"
+#include "clock.h"
+#include "nordic_common.h"
+#include "scheduler.h"
+#include "timers.h"
+
+STATIC_ASSERT(IS_POWER_OF_TWO(TIMERS_SLOT_COUNT));
+
+static timers_timer_t *     m_slots[TIMERS_SLOT_COUNT];
+static timers_timer_t *     m_expired;                  // The expired timers whose handlers haven't been called yet.
+static uint64_t             m_position;                 // The slot we are in, counted on the 64 bit clock. Every slot before it has been expired.
+static uint32_t             m_count;
+
+
+void timers_init(void)
+{
+    memset(m_slots, 0, sizeof(m_slots));
+    m_expired = NULL;
+    m_position = clock_get_ticks64() >> TIMERS_SLOT_SHIFT;
+    m_count = 0;
+}
+
+
+void timers_tasks(void)
+{
+    uint64_t now_ticks = clock_get_ticks64();
+    uint64_t now_slot = now_ticks >> TIMERS_SLOT_SHIFT;
+
+    // After a long sleep there is no point going round the wheel more than once.
+    if ((now_slot - m_position) >= TIMERS_SLOT_COUNT)
+    {
+        m_position = now_slot - TIMERS_SLOT_COUNT + 1;
+    }
+
+    for (; m_position <= now_slot; m_position++)
+    {
+        timers_expire_slot((uint32_t)m_position & (TIMERS_SLOT_COUNT - 1), now_ticks);
+    }
+
+    // The slot we are in may still hold timers that expire later in it, so it is looked at again.
+    m_position = now_slot;
+
+    // The handlers may start and stop any timer, including the expired ones that are still
+    // waiting for their handler, so take them off the list one at a time.
+    while (NULL != m_expired)
+    {
+        timers_timer_t * p_timer = m_expired;
+        timers_remove(p_timer);
+        if (0 != p_timer->period_ticks)
+        {
+            // Stay on the period, unless we fell more than a whole period behind.
+            p_timer->expiry_ticks += p_timer->period_ticks;
+            if (p_timer->expiry_ticks <= now_ticks)
+            {
+                p_timer->expiry_ticks = now_ticks + p_timer->period_ticks;
+            }
+
+            timers_insert(p_timer);
+        }
+
+        p_timer->handler(p_timer->p_context);
+    }
+
+    scheduler_set_wakeup(SCHEDULER_MODULE_TIMERS, timers_next_expiry());
+}
+
+
+void timers_create(timers_timer_t * p_timer, timers_handler_t handler, void * p_context)
+{
+    memset(p_timer, 0, sizeof(*p_timer));
+    p_timer->handler = handler;
+    p_timer->p_context = p_context;
+}
+
+
+void timers_start(timers_timer_t * p_timer, uint32_t timeout_ms, uint32_t period_ms)
+{
+    timers_start_at(p_timer, clock_get_ticks64() + CLOCK_MS_IN_TICKS(timeout_ms), period_ms);
+}
+
+
+void timers_start_at(timers_timer_t * p_timer, uint64_t expiry_ticks, uint32_t period_ms)
+{
+    timers_stop(p_timer);
+
+    p_timer->expiry_ticks = expiry_ticks;
+    p_timer->period_ticks = CLOCK_MS_IN_TICKS(period_ms);
+    timers_insert(p_timer);
+
+    // The wakeup is brought up to date before the main loop sleeps.
+    scheduler_set_pending(SCHEDULER_MODULE_TIMERS);
+}
+
+
+void timers_stop(timers_timer_t * p_timer)
+{
+    if (timers_is_running(p_timer))
+    {
+        timers_remove(p_timer);
+    }
+}
+
+
+bool timers_is_running(timers_timer_t const * p_timer)
+{
+    return NULL != p_timer->pp_prev;
+}
+
+
+uint32_t timers_ms_until(timers_timer_t const * p_timer)
+{
+    uint64_t now_ticks = clock_get_ticks64();
+    if (!timers_is_running(p_timer) || (p_timer->expiry_ticks <= now_ticks))
+    {
+        return 0;
+    }
+
+    return CLOCK_TICKS_IN_MS(p_timer->expiry_ticks - now_ticks);
+}
+
+
+uint32_t timers_get_count(void)
+{
+    return m_count;
+}
+
+
+void timers_pending_handler(void * p_context)
+{
+    scheduler_set_pending((scheduler_module_t)(uint32_t)p_context);
+}
+
+
+static void timers_insert(timers_timer_t * p_timer)
+{
+    // A timer that is already due goes in the slot we are in, the ones behind it won't be
+    // looked at again until the wheel comes round.
+    uint64_t position = MAX(p_timer->expiry_ticks >> TIMERS_SLOT_SHIFT, m_position);
+    timers_timer_t ** pp_slot = &m_slots[(uint32_t)position & (TIMERS_SLOT_COUNT - 1)];
+
+    // Add to the front, so a timer that is put back while its slot is being expired isn't seen twice.
+    p_timer->p_next = *pp_slot;
+    p_timer->pp_prev = pp_slot;
+    if (NULL != p_timer->p_next)
+    {
+        p_timer->p_next->pp_prev = &p_timer->p_next;
+    }
+
+    *pp_slot = p_timer;
+    m_count++;
+}
+
+
+static void timers_remove(timers_timer_t * p_timer)
+{
+    *p_timer->pp_prev = p_timer->p_next;
+    if (NULL != p_timer->p_next)
+    {
+        p_timer->p_next->pp_prev = p_timer->pp_prev;
+    }
+
+    p_timer->p_next = NULL;
+    p_timer->pp_prev = NULL;
+    m_count--;
+}
+
+
+static void timers_expire_slot(uint32_t slot, uint64_t now_ticks)
+{
+    timers_timer_t * p_timer = m_slots[slot];
+    while (NULL != p_timer)
+    {
+        timers_timer_t * p_next = p_timer->p_next;
+        if (p_timer->expiry_ticks <= now_ticks)
+        {
+            timers_remove(p_timer);
+
+            // The expired list is also counted, its timers are still running until their handler is called.
+            p_timer->p_next = m_expired;
+            p_timer->pp_prev = &m_expired;
+            if (NULL != m_expired)
+            {
+                m_expired->pp_prev = &p_timer->p_next;
+            }
+
+            m_expired = p_timer;
+            m_count++;
+        }
+
+        p_timer = p_next;
+    }
+}
+
+
+static uint64_t timers_next_expiry(void)
+{
+    uint64_t next_expiry = SCHEDULER_NO_WAKEUP;
+    for (uint32_t distance = 0; (0 != m_count) && (distance < TIMERS_SLOT_COUNT); distance++)
+    {
+        uint64_t position = m_position + distance;
+        uint64_t slot_end_ticks = (position + 1) << TIMERS_SLOT_SHIFT;
+        bool is_due = false;
+
+        for (timers_timer_t * p_timer = m_slots[(uint32_t)position & (TIMERS_SLOT_COUNT - 1)];
+             NULL != p_timer;
+             p_timer = p_timer->p_next)
+        {
+            next_expiry = MIN(next_expiry, p_timer->expiry_ticks);
+            is_due = is_due || (p_timer->expiry_ticks < slot_end_ticks);
+        }
+
+        // Nothing in the slots before this one is due this turn, so nothing can expire sooner.
+        if (is_due)
+        {
+            break;
+        }
+    }
+
+    return next_expiry;
+}
+
+
+/** @} */
@@ -0,0 +1,170 @@
+/**
+ * @file
+ * @defgroup WaterBall timers.h
+ * @{
+ * @ingroup WaterBall
+ * @brief WaterBall software timers module.
+ *
+ * A hashed timer wheel for the timeouts of the modules, so that they don't have to keep
+ * their own start ticks and poll the clock. The wheel is an array of slots, each slot
+ * covers TIMERS_SLOT_TICKS of the 64 bit clock, and a timer is linked into the slot that
+ * its expiry hashes to. Timers that are more than one turn of the wheel away share the
+ * slots with the near ones, their expiry tells them apart. Starting and stopping a timer
+ * is O(1) no matter how many timers are running, and the timers belong to the callers so
+ * there is no limit on how many there are.
+ *
+ * The scheduler is asked to wake the timers module at the earliest expiry, and it sleeps
+ * until then if nothing else comes up. The handlers of the expired timers are called
+ * from timers_tasks in the main loop, so they can do the same things as any tasks
+ * function. Most of them just make their module pending with timers_pending_handler.
+ *
+ * Timers must only be started and stopped from the main loop.
+ */
+
+#ifndef TIMERS_H__
+#define TIMERS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TIMERS_SLOT_SHIFT               (5)                                     /**< A slot covers 32 ticks, just under 1 ms. */
+#define TIMERS_SLOT_TICKS               (1UL << TIMERS_SLOT_SHIFT)
+#define TIMERS_SLOT_COUNT               (128)                                   /**< One turn of the wheel is 125 ms, it must be a power of two. */
+
+/**
+ * @brief   A timer handler, it is called from the main loop.
+ */
+typedef void (* timers_handler_t)(void * p_context);
+
+/**
+ * @brief   A timer, it must stay in memory while it is running.
+ */
+typedef struct timers_timer_s
+{
+    struct timers_timer_s *     p_next;             /**< The next timer in the same slot. */
+    struct timers_timer_s **    pp_prev;            /**< The pointer that points to this timer, NULL if it isn't running. */
+    uint64_t                    expiry_ticks;       /**< When the timer expires, on the 64 bit clock. */
+    uint32_t                    period_ticks;       /**< How often the timer repeats, 0 if it is one-shot. */
+    timers_handler_t            handler;
+    void *                      p_context;
+} timers_timer_t;
+
+/**
+ * @brief   Function to initialize the timers module.
+ */
+void timers_init(void);
+
+/**
+ * @brief   Function to accomplish the timers module tasks.
+ *
+ * @details Calls the handlers of the timers that have expired and asks the scheduler to
+ *          wake it for the next expiry.
+ */
+void timers_tasks(void);
+
+/**
+ * @brief   Set up a timer, it is stopped until it is started.
+ *
+ * @param[out]  p_timer         The timer to set up.
+ * @param[in]   handler         The function to call when the timer expires.
+ * @param[in]   p_context       Passed to the handler.
+ */
+void timers_create(timers_timer_t * p_timer, timers_handler_t handler, void * p_context);
+
+/**
+ * @brief   Start a timer, or restart it if it is already running.
+ *
+ * @param[in]   p_timer         The timer to start.
+ * @param[in]   timeout_ms      How long until the timer first expires.
+ * @param[in]   period_ms       How often the timer expires after that, or 0 for a one-shot timer.
+ */
+void timers_start(timers_timer_t * p_timer, uint32_t timeout_ms, uint32_t period_ms);
+
+/**
+ * @brief   Start a timer at a time on the 64 bit clock, or restart it if it is already running.
+ *
+ * @details This is for timers that have to line up with something else, like the same
+ *          moment on the peer, rather than with when they were started. A time that has
+ *          already passed expires the next time the timers run.
+ *
+ * @param[in]   p_timer         The timer to start.
+ * @param[in]   expiry_ticks    When the timer first expires, from clock_get_ticks64.
+ * @param[in]   period_ms       How often the timer expires after that, or 0 for a one-shot timer.
+ */
+void timers_start_at(timers_timer_t * p_timer, uint64_t expiry_ticks, uint32_t period_ms);
+
+/**
+ * @brief   Stop a timer, it is fine to stop a timer that isn't running.
+ *
+ * @param[in]   p_timer         The timer to stop.
+ */
+void timers_stop(timers_timer_t * p_timer);
+
+/**
+ * @brief   Test to see if a timer is running. A one-shot timer stops when it expires.
+ *
+ * @param[in]   p_timer         The timer.
+ *
+ * @retval      True if the timer is running.
+ */
+bool timers_is_running(timers_timer_t const * p_timer);
+
+/**
+ * @brief   Get the number of milliseconds until a timer expires.
+ *
+ * @param[in]   p_timer         The timer.
+ *
+ * @retval      The time until the timer expires, or 0 if it isn't running.
+ */
+uint32_t timers_ms_until(timers_timer_t const * p_timer);
+
+/**
+ * @brief   Get the number of timers that are running.
+ *
+ * @retval      The number of running timers.
+ */
+uint32_t timers_get_count(void);
+
+/**
+ * @brief   A timer handler that makes a module pending.
+ *
+ * @param[in]   p_context       The scheduler_module_t to make pending, cast to a pointer.
+ */
+void timers_pending_handler(void * p_context);
+
+/**
+ * @brief   Link a timer into the slot that its expiry hashes to.
+ *
+ * @param[in]   p_timer         The timer, it must not be running.
+ */
+static void timers_insert(timers_timer_t * p_timer);
+
+/**
+ * @brief   Unlink a timer from the list it is on.
+ *
+ * @param[in]   p_timer         The timer, it must be running.
+ */
+static void timers_remove(timers_timer_t * p_timer);
+
+/**
+ * @brief   Move the expired timers of a slot to the expired list.
+ *
+ * @param[in]   slot            The index of the slot.
+ * @param[in]   now_ticks       The time now, on the 64 bit clock.
+ */
+static void timers_expire_slot(uint32_t slot, uint64_t now_ticks);
+
+/**
+ * @brief   Find the earliest expiry of all of the running timers.
+ *
+ * @details Starting from the current slot, the first slot that holds a timer that is due
+ *          in this turn of the wheel has the earliest expiry, so the search usually stops
+ *          well before it has looked at every timer.
+ *
+ * @retval      The earliest expiry, or SCHEDULER_NO_WAKEUP if no timer is running.
+ */
+static uint64_t timers_next_expiry(void);
+
+#endif //TIMERS_H__
+
+/** @} */